@@ -13,11 +13,141 @@ typedef struct {
 
 int pacman_connect(char const *req_pipe_path, char const *notif_pipe_path, char const *server_pipe_path);
 
+/// Like pacman_connect, asking the server to deliver boards through the given
+/// transport (TRANSPORT_PIPE or TRANSPORT_SHM, see protocol.h). The server may
+/// fall back to the pipe; pacman_transport() tells which one is in use.
+int pacman_connect_ex(char const *req_pipe_path, char const *notif_pipe_path, char const *server_pipe_path,
+                      int transport);
+
+int pacman_transport(void);
+
+/// Connects through the server's Unix socket listener (server option -u).
+/// Every message is one SOCK_SEQPACKET datagram and no FIFOs are created.
+/// @return 0 if the connection was successful, 1 otherwise.
+int pacman_connect_unix(char const *socket_path, int client_id, int transport);
+
 void pacman_play(char command);
 
+typedef struct {
+  char command;
+  int repeat;  // ticks seguidos a jogar o comando (>= 1)
+} play_cmd_t;
+
+/// Sends n commands in as few messages as possible (OP_CODE_PLAY_BATCH, up
+/// to MAX_PLAY_BATCH each). The server keeps at least MAX_PLAY_BATCH commands
+/// per session: a message sent once the previous ones were played is played
+/// in full.
+/// @return 0 if every command was sent, 1 otherwise.
+int pacman_play_batch(play_cmd_t const *cmds, int n);
+
 /// @return 0 if the disconnection was successful, 1 otherwise.
 int pacman_disconnect();
 
 Board receive_board_update(void);
 
+/// Blocks until the next complete board arrives, for at most timeout_ms
+/// milliseconds (-1: no limit). Boards that reach the pipe in pieces are
+/// reassembled; exactly one board is returned per call. Returns an empty
+/// board (data == NULL, game_over == 0) on timeout or after
+/// receive_board_cancel, and game_over == 1 without data when the server
+/// closes the session.
+Board receive_board_wait(int timeout_ms);
+
+/// Results of the *_into receive functions.
+enum { RECEIVE_CLOSED = -1, RECEIVE_NONE = 0, RECEIVE_BOARD = 1 };
+
+/// Like receive_board_wait, decoding into a board owned by the caller:
+/// board->data is reused and only reallocated when the dimensions change, so
+/// receiving in a loop does no heap allocation. The board must start zeroed
+/// (or hold the result of a previous call) and is freed with release_board.
+/// On RECEIVE_NONE (timeout, cancel) and RECEIVE_CLOSED (the server closed
+/// the session) the board keeps its previous contents. With TRANSPORT_SHM the
+/// frame is copied and its ring slot given back at once.
+int receive_board_into(Board *board, int timeout_ms);
+
+/// Makes a receive_board_wait or receive_board_into blocked in another thread
+/// return at once (or the next one, if none is waiting).
+void receive_board_cancel(void);
+
+/// Gives back a board returned by receive_board_update (boards must be released
+/// in the order they were received). With TRANSPORT_SHM board.data points into
+/// shared memory and must not be freed directly.
+void release_board(Board *board);
+
+// ---- Several sessions per process ----
+// The functions above drive one implicit session. The ones below work on
+// handles, so a process can keep any number of sessions open. Handles are
+// not thread-safe: use each one (and each mux) from a single thread at a time.
+
+typedef struct Session pacman_session_t;
+
+/// Like pacman_connect_ex / pacman_connect_unix, for a new session.
+/// @return the session handle, or NULL if the connection failed.
+pacman_session_t *pacman_session_connect(char const *req_pipe_path, char const *notif_pipe_path,
+                                         char const *server_pipe_path, int transport);
+pacman_session_t *pacman_session_connect_unix(char const *socket_path, int client_id, int transport);
+
+/// The session_id of a multiplexed session, the client_id given to
+/// pacman_session_connect_unix, or -1.
+int pacman_session_id(pacman_session_t const *s);
+int pacman_session_transport(pacman_session_t const *s);
+
+/// The descriptor frames arrive on, for waiting on many sessions with poll()
+/// (POLLIN: call pacman_session_receive_into with timeout 0 until it returns
+/// RECEIVE_NONE). -1 for sessions of a mux. With TRANSPORT_SHM it only
+/// signals the end of the session.
+int pacman_session_fd(pacman_session_t const *s);
+
+void pacman_session_play(pacman_session_t *s, char command);
+int pacman_session_play_batch(pacman_session_t *s, play_cmd_t const *cmds, int n);
+
+/// Non-blocking, like receive_board_update. Sessions of a mux receive
+/// through pacman_mux_receive instead (this returns an empty board).
+Board pacman_session_receive(pacman_session_t *s);
+Board pacman_session_wait(pacman_session_t *s, int timeout_ms);
+int pacman_session_receive_into(pacman_session_t *s, Board *board, int timeout_ms);
+void pacman_session_cancel(pacman_session_t *s);
+void pacman_session_release_board(pacman_session_t *s, Board *board);
+
+/// Ends the session and frees the handle.
+/// @return 0 if the disconnection was successful, 1 otherwise.
+int pacman_session_disconnect(pacman_session_t *s);
+
+// ---- Multiplexed channel ----
+// One pair of SOCK_SEQPACKET channels to the server's socket listener
+// carries many sessions, each tagged with a client-chosen session_id
+// (0 <= session_id < MUX_MAX_SESSIONS). No FIFOs are created.
+
+typedef struct pacman_mux pacman_mux_t;
+
+/// @return the channel, or NULL if the server refused it.
+pacman_mux_t *pacman_mux_connect(char const *socket_path, int client_id);
+
+/// Opens a session in the channel and waits for the server to admit it
+/// (boards of other sessions arriving meanwhile are kept for
+/// pacman_mux_receive). The session_id stays in use until the server
+/// confirms the end of the session. The server answers at once: it refuses
+/// the session, rather than making the channel wait, while its admission
+/// queue is full or all max_games sessions are in play.
+/// @return the session handle, or NULL if refused (the session_id can be
+/// opened again later).
+pacman_session_t *pacman_mux_open_session(pacman_mux_t *mux, int session_id);
+
+/// Non-blocking: the next board of any session in the channel, with *from
+/// set to its session. When a session ends, returns a board with
+/// game_over = 1 and no data for it (then call pacman_session_disconnect).
+/// A board with game_over = 1 and *from == NULL means the channel closed.
+/// Boards are released with pacman_session_release_board.
+Board pacman_mux_receive(pacman_mux_t *mux, pacman_session_t **from);
+
+/// Like pacman_mux_receive, decoding into a caller-owned board as
+/// receive_board_into does (one board can serve every session of the
+/// channel). RECEIVE_CLOSED with *from set means that session ended; with
+/// *from == NULL, the channel closed.
+int pacman_mux_receive_into(pacman_mux_t *mux, pacman_session_t **from, Board *board);
+
+/// Closes the channel: every session still open in it ends and its handle
+/// is freed.
+void pacman_mux_disconnect(pacman_mux_t *mux);
+
 #endif
\ No newline at end of file
@@ -7,6 +7,8 @@
 #define MAX_GHOSTS 25
 
 #include <pthread.h>
+#include <stdint.h>
+#include <stddef.h>
 
 typedef enum {
     REACHED_PORTAL = 1,
@@ -42,16 +44,35 @@ typedef struct {
     int charged;
 } ghost_t;
 
+/*
+Board layout, chosen at compile time (make BOARD_LAYOUT=compact defines BOARD_COMPACT):
+ - default: one board_pos_t per cell, each with its own mutex (~48 bytes per cell)
+ - compact: a content byte plane, dot/portal bitsets and a small table of region
+   locks (~1.25 bytes per cell)
+Code outside board.c reaches the cells only through the accessors below
+*/
+#ifndef BOARD_COMPACT
 typedef struct {
     char content; // stuff like 'P' for pacman 'M' for monster and 'W' for wall
     int has_dot; // whether there is a dot in this position or not
     int has_portal; // whether there is a portal in this position or not
     pthread_mutex_t lock;
 } board_pos_t;
+#else
+#define BOARD_LOCK_STRIPES 64 // size of the lock table (one bit each in a uint64_t mask)
+#define BOARD_LOCK_REGION 64 // consecutive cells sharing a lock (one bitset word)
+#endif
 
 typedef struct {
     int width, height; //dimensions of the board
+#ifndef BOARD_COMPACT
     board_pos_t* board; //actual board, most likely a row-major matrix
+#else
+    char* content; // row-major content plane ('P', 'M', 'W' or ' ')
+    uint64_t* dots; // bitset: cell has a dot
+    uint64_t* portals; // bitset: cell has a portal
+    pthread_mutex_t locks[BOARD_LOCK_STRIPES]; // region locks, see board_lock_*
+#endif
     int n_pacmans; //number of pacmans in the board
     pacman_t* pacmans; // array containing every pacman in the board to iterate through when processing
     int n_ghosts; //number of ghosts
@@ -61,8 +82,78 @@ typedef struct {
     char ghosts_files[MAX_GHOSTS][256]; // files with monster movements
     int tempo; // Duracao de cada jogada
     pthread_rwlock_t state_lock;
+    char* display; // rendered board (same chars as get_board_displayed), kept up to date by the moves
+    int n_dots; // dots the level started with
+    int dots_left; // dots still on the board (updated by move_pacman)
+    int portal_reached; // set by move_pacman when a pacman steps into a portal
 } board_t;
 
+/*Cell accessors (index = y * width + x)*/
+#ifndef BOARD_COMPACT
+static inline char board_content(const board_t* board, int index) {
+    return board->board[index].content;
+}
+static inline void board_set_content(board_t* board, int index, char content) {
+    board->board[index].content = content;
+}
+static inline int board_has_dot(const board_t* board, int index) {
+    return board->board[index].has_dot;
+}
+static inline void board_set_dot(board_t* board, int index, int value) {
+    board->board[index].has_dot = value;
+}
+static inline int board_has_portal(const board_t* board, int index) {
+    return board->board[index].has_portal;
+}
+static inline void board_set_portal(board_t* board, int index, int value) {
+    board->board[index].has_portal = value;
+}
+#else
+static inline int bitset_get(const uint64_t* bits, int index) {
+    return (bits[index >> 6] >> (index & 63)) & 1;
+}
+static inline void bitset_set(uint64_t* bits, int index, int value) {
+    if (value) bits[index >> 6] |= (uint64_t)1 << (index & 63);
+    else bits[index >> 6] &= ~((uint64_t)1 << (index & 63));
+}
+static inline char board_content(const board_t* board, int index) {
+    return board->content[index];
+}
+static inline void board_set_content(board_t* board, int index, char content) {
+    board->content[index] = content;
+}
+static inline int board_has_dot(const board_t* board, int index) {
+    return bitset_get(board->dots, index);
+}
+static inline void board_set_dot(board_t* board, int index, int value) {
+    bitset_set(board->dots, index, value);
+}
+static inline int board_has_portal(const board_t* board, int index) {
+    return bitset_get(board->portals, index);
+}
+static inline void board_set_portal(board_t* board, int index, int value) {
+    bitset_set(board->portals, index, value);
+}
+#endif
+
+/*Allocates the (zeroed) cells for board->width x board->height, no locks*/
+int board_alloc_cells(board_t* board);
+/*Allocates dst's cells and copies src's (same dimensions)*/
+int board_copy_cells(board_t* dst, const board_t* src);
+/*Frees the cells allocated by board_alloc_cells/board_copy_cells*/
+void board_free_cells(board_t* board);
+/*Bytes used by the cells of a board (layout dependent)*/
+size_t board_cells_bytes(const board_t* board);
+
+/*Cell locking: init/destroy all locks, lock two cells, lock a line of count cells
+starting at index start and spaced by stride. Locks are always taken in a global order*/
+void board_init_locks(board_t* board);
+void board_destroy_locks(board_t* board);
+void board_lock_cells(board_t* board, int a, int b);
+void board_unlock_cells(board_t* board, int a, int b);
+void board_lock_line(board_t* board, int start, int count, int stride);
+void board_unlock_line(board_t* board, int start, int count, int stride);
+
 /*Move pacman/monster in a certain direction on the board must check for boundaries, walls and other monsters
 Maybe do 1 function for pacman and 1 for monsters if required
 Maybe do 1 function for each direction
@@ -84,6 +175,16 @@ int load_ghost(board_t* board);
 Fils the board with the information coming from the file
 */
 int load_level(board_t* board, char* filename, char* dirname, int accumulated_points);
+/*
+Instantiates a level already compiled in memory (see level_cache.h): copies the
+cells and the entity tables, no file is read
+*/
+int load_level_from(board_t* board, const board_t* level, int accumulated_points);
+/*
+Renders the whole board into board->display (allocating it if needed); after this
+the moves keep it up to date cell by cell
+*/
+int board_display_rebuild(board_t* board);
 // Unloads levels loaded by load_level
 void unload_level(board_t * board);
 
@@ -1,6 +1,8 @@
 #ifndef DEBUG_H
 #define DEBUG_H
 
+#include <time.h>
+
 // DEBUG FILE
 
 void open_debug_file(char *filename);
@@ -11,4 +13,16 @@ void debug(const char * format, ...);
 
 void sleep_ms(int milliseconds);
 
+// TEMPO MONOTÓNICO
+
+void timespec_add_ms(struct timespec* ts, int milliseconds);
+
+int timespec_cmp(const struct timespec* a, const struct timespec* b);
+
+// Diferença a - b em milissegundos
+long timespec_diff_ms(const struct timespec* a, const struct timespec* b);
+
+// Diferença a - b em microssegundos
+long timespec_diff_us(const struct timespec* a, const struct timespec* b);
+
 #endif
\ No newline at end of file
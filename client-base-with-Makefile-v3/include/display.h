@@ -17,10 +17,23 @@ Potential Structures for ncurses
 /*Initialize everything ncurses requires*/
 int terminal_init();
 
+/*Same as terminal_init, for a terminal of the given type whose output goes to
+out instead of the screen (used by render_bench to count the bytes sent)*/
+int terminal_init_file(FILE* out, FILE* in, const char* term);
+
+/*Draw a board received from the server. Only the cells, status line and points
+that changed since the previous call are redrawn*/
 void draw_board_client(Board board);
 
+/*Make the next draw_board_client redraw everything (after the screen was
+cleared or drawn over by something else)*/
+void draw_board_client_invalidate();
+
 char* get_board_displayed(board_t* board);
 
+/*Same as get_board_displayed but writes width*height chars into output (no '\0')*/
+void fill_board_displayed(board_t* board, char* output);
+
 /*Draw the board on the screen*/
 void draw_board(board_t* board, int mode);
 
@@ -0,0 +1,49 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <time.h>
+
+// Motor de execução: um conjunto fixo de threads que executa os eventos
+// (passos do pacman, dos fantasmas e notificações) de todas as sessões a
+// partir de um escalonador central com prazos absolutos (CLOCK_MONOTONIC).
+
+typedef struct engine_task engine_task_t;
+
+// Evento agendado: "executar a entidade (kind, index) da tarefa em due"
+typedef struct {
+    struct timespec due;
+    engine_task_t* task;
+    int kind;
+    int index;
+    unsigned gen;           // geração da tarefa quando o evento foi agendado
+} engine_event_t;
+
+// Executa o evento. Devolve 1 para o voltar a agendar em ev->due (que a
+// tarefa atualiza), ou 0 para o descartar.
+typedef int (*engine_task_fn)(engine_task_t* task, engine_event_t* ev);
+
+struct engine_task {
+    engine_task_fn run;
+};
+
+// Arranca n_threads threads do motor (n_threads <= 0: número de cores)
+int engine_init(int n_threads);
+
+// Número de threads do motor em execução
+int engine_threads(void);
+
+// Reserva lugar no escalonador para n_events eventos, antes de os agendar.
+// O lugar fica com o evento enquanto ele for reagendado e é libertado
+// quando a tarefa o descarta, por isso engine_schedule nunca falha.
+// Devolve -1 se não há memória (nada fica reservado).
+int engine_reserve(int n_events);
+
+// Agenda um evento da tarefa para o instante due (com lugar já reservado)
+void engine_schedule(engine_task_t* task, int kind, int index, unsigned gen,
+                     const struct timespec* due);
+
+// Avança *due um período; se o atraso já passar de um período, recomeça a
+// partir de now (não tenta recuperar ticks perdidos de uma só vez)
+void engine_next_deadline(struct timespec* due, int period_ms, const struct timespec* now);
+
+#endif
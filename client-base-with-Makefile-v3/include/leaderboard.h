@@ -0,0 +1,28 @@
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+// Classificação das sessões ativas, mantida ordenada (pontuação decrescente)
+// à medida que as pontuações mudam: obter o top-K custa O(K) seja qual for o
+// número de sessões. Os slots são os índices de sessions[].
+
+typedef struct {
+    int client_id;
+    int points;
+} leaderboard_entry_t;
+
+// Cria a classificação para slots 0..capacity-1
+int leaderboard_init(int capacity);
+void leaderboard_destroy(void);
+
+// Sessão admitida / terminada
+void leaderboard_add(int slot, int client_id, int points);
+void leaderboard_remove(int slot);
+
+// Nova pontuação de uma sessão (chamar apenas quando muda)
+void leaderboard_update(int slot, int points);
+
+// Copia para out as k melhores sessões; devolve quantas copiou.
+// *active recebe o número total de sessões na classificação (se não NULL).
+int leaderboard_top(leaderboard_entry_t* out, int k, int* active);
+
+#endif
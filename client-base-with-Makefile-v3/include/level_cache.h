@@ -0,0 +1,27 @@
+#ifndef LEVEL_CACHE_H
+#define LEVEL_CACHE_H
+
+#include "board.h"
+
+// Cache global dos níveis já compilados (tabuleiro + pacman + fantasmas),
+// construída uma única vez no arranque e só de leitura a partir daí.
+// Os níveis ficam pela ordem em que aparecem na diretoria.
+
+// Lê e compila todos os .lvl da diretoria. Devolve o número de níveis ou -1.
+int level_cache_build(char* dirname);
+
+// Número de níveis em cache
+int level_cache_count(void);
+
+// Maior número de células (width * height) entre os níveis em cache
+int level_cache_max_cells(void);
+
+// Nível compilado na posição index (NULL se fora dos limites)
+const board_t* level_cache_get(int index);
+
+// Procura um nível pelo nome do ficheiro (NULL se não estiver em cache)
+const board_t* level_cache_find(const char* dirname, const char* filename);
+
+void level_cache_destroy(void);
+
+#endif
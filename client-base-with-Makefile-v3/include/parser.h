@@ -3,12 +3,9 @@
 
 #include "board.h"
 
-#define MAX_COMMAND_LENGTH 256
-
 int read_level(board_t* board, char* filename, char* dirname);
 int read_pacman(board_t* board, int points);
 int read_ghosts(board_t* board);
-int read_line(int fd, char *buf);
 
 #endif
 
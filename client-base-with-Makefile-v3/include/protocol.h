@@ -8,6 +8,58 @@ enum {
   OP_CODE_DISCONNECT = 2,
   OP_CODE_PLAY = 3,
   OP_CODE_BOARD = 4,
+  OP_CODE_BOARD_DELTA = 5,
+  OP_CODE_PLAY_BATCH = 6,
+  OP_CODE_CONNECT_EX = 7,
+  OP_CODE_MUX = 8,
 };
 
+// Transporte dos tabuleiros (servidor -> cliente)
+enum {
+  TRANSPORT_PIPE = 0,   // FIFO de notificações (OP_CODE_BOARD / OP_CODE_BOARD_DELTA)
+  TRANSPORT_SHM = 1,    // anel em memória partilhada (ver shm_ring.h)
+  TRANSPORT_MUX = 2,    // canal partilhado por várias sessões (só por socket, ver OP_CODE_MUX)
+};
+
+// OP_CODE_BOARD_DELTA: 5 | victory (int) | game_over (int) | points (int) |
+// n_changes (int) | n_changes x { index (int) | cell (char) }
+// Só altera as células indicadas do último tabuleiro recebido (mesmas
+// dimensões e tempo do último OP_CODE_BOARD, que serve de keyframe).
+#define DELTA_ENTRY_SIZE ((int)sizeof(int) + 1)
+
+// OP_CODE_PLAY_BATCH: 6 | n (int) | n x { command (char) | repeat (int) }
+// Equivale a n comandos OP_CODE_PLAY, cada um jogado repeat ticks seguidos
+// (como "T n" nos ficheiros de movimentos). Com n <= MAX_PLAY_BATCH a
+// mensagem cabe em PIPE_BUF e é escrita de forma atómica.
+#define MAX_PLAY_BATCH 64
+#define PLAY_BATCH_ENTRY_SIZE (1 + (int)sizeof(int))
+#define PLAY_BATCH_HEADER_SIZE (1 + (int)sizeof(int))
+
+// OP_CODE_CONNECT_EX: 7 | req_pipe (40) | notif_pipe (40) | transport (char)
+// Resposta: 1 | result (char) | transport (char) | shm_name (40)
+// O servidor responde com o transporte que aceitou (pode recusar a memória
+// partilhada e ficar pelo FIFO); shm_name só tem significado com TRANSPORT_SHM.
+#define SHM_NAME_FIELD_LENGTH 40
+
+// Ligação por socket Unix SOCK_SEQPACKET (servidor com -u): cada mensagem
+// (pedido, comando, tabuleiro) é um datagrama. O pedido de ligação é
+//   1 | transport (char) | client_id (int)
+// com dois descritores em SCM_RIGHTS, os canais de pedidos e de notificações
+// (pontas de socketpairs do cliente, em vez dos dois FIFOs). A resposta
+// chega pelo canal de notificações no formato da de OP_CODE_CONNECT_EX.
+#define SOCKET_CONNECT_SIZE (2 + (int)sizeof(int))
+
+// Canal multiplexado: um pedido por socket com transport = TRANSPORT_MUX
+// (resposta com TRANSPORT_MUX) abre um par de canais por onde passam
+// muitas sessões. Cada datagrama, nos dois sentidos, é
+//   8 | session_id (int) | mensagem normal
+// O cliente escolhe session_id (0 <= id < MUX_MAX_SESSIONS) e abre a sessão
+// com a mensagem OP_CODE_CONNECT (1 byte); a resposta tem o formato da de
+// OP_CODE_CONNECT_EX (transporte sempre TRANSPORT_PIPE). Seguem-se
+// OP_CODE_PLAY / OP_CODE_PLAY_BATCH / OP_CODE_DISCONNECT do cliente e
+// OP_CODE_BOARD / OP_CODE_BOARD_DELTA do servidor; quando a sessão termina
+// o servidor envia OP_CODE_DISCONNECT (em vez de fechar o canal).
+#define MUX_HEADER_SIZE (1 + (int)sizeof(int))
+#define MUX_MAX_SESSIONS 4096
+
 #endif
\ No newline at end of file
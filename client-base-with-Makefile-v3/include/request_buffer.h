@@ -0,0 +1,62 @@
+#ifndef REQUEST_BUFFER_H
+#define REQUEST_BUFFER_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+struct mux_conn;
+
+// Pedido de conexão (campos do protocolo + instante de entrada na fila)
+typedef struct {
+    char req_pipe_path[40];
+    char notif_pipe_path[40];
+    int client_id;
+    int transport;              // TRANSPORT_* pedido pelo cliente
+    int req_fd;                 // canais já abertos (ligação por socket), ou -1
+    int notif_fd;
+    struct mux_conn* mux;       // sessão aberta num canal multiplexado, ou NULL
+    int mux_id;                 // session_id da sessão nesse canal
+    struct timespec enqueued;   // CLOCK_MONOTONIC, para medir a latência de admissão
+} connection_request_t;
+
+// Posição do anel: seq indica se está livre para o produtor da volta atual
+// (seq == pos) ou preenchida para o consumidor (seq == pos + 1)
+typedef struct {
+    _Atomic size_t seq;
+    connection_request_t req;
+} request_slot_t;
+
+// Fila circular limitada MPMC sem locks (algoritmo de Vyukov). As threads só
+// bloqueiam (futex) quando a fila está cheia ou vazia.
+typedef struct {
+    request_slot_t* slots;
+    size_t mask;                                // capacidade - 1 (potência de 2)
+    int spin;                                   // tentativas antes de dormir
+    _Alignas(64) _Atomic size_t enqueue_pos;
+    _Alignas(64) _Atomic size_t dequeue_pos;
+    _Alignas(64) _Atomic uint32_t put_seq;      // futex: muda a cada put
+    _Atomic uint32_t get_seq;                   // futex: muda a cada get
+    _Atomic int waiting_consumers;
+    _Atomic int waiting_producers;
+} request_buffer_t;
+
+// Funções do buffer (size é arredondado para a potência de 2 seguinte)
+int buffer_init(request_buffer_t *buf, int size);
+void buffer_destroy(request_buffer_t *buf);
+int buffer_capacity(const request_buffer_t *buf);
+
+// Bloqueantes: esperam por espaço / por um pedido
+void buffer_put(request_buffer_t *buf, connection_request_t req);
+connection_request_t buffer_get(request_buffer_t *buf);
+
+// Não bloqueantes: devolvem 0 em caso de sucesso, -1 se cheia / vazia
+int buffer_try_put(request_buffer_t *buf, const connection_request_t* req);
+int buffer_try_get(request_buffer_t *buf, connection_request_t* req);
+
+// Como buffer_put sem esperar por espaço (-1 se cheia): para threads que não
+// podem adormecer na fila global
+int buffer_put_nowait(request_buffer_t *buf, const connection_request_t* req);
+
+#endif
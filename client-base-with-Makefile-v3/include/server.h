@@ -2,43 +2,75 @@
 #define SERVER_H
 
 #include "board.h"
-#include <semaphore.h>
+#include "request_buffer.h"
+#include "shm_ring.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
 
-#define MAX_PENDING_CONNECTIONS 10
+#define MAX_PENDING_CONNECTIONS 16  // capacidade por omissão da fila de pedidos (-q)
+#define MAX_WORKER_THREADS 4  // workers de admissão (as sessões correm no motor)
+#define DEFAULT_KEYFRAME_INTERVAL 20  // frames delta entre dois tabuleiros completos
+#define TOP5_LOG_FILE "top5_clients.log"
+#define DEFAULT_SLOW_CONSUMER_MS 5000  // cliente sem ler notificações durante mais do que isto é desligado (-s)
+#define NOTIF_DRAIN_PERIOD_MS 10      // intervalo entre tentativas de escoar frames no fim da sessão
 
-// Pedido de conexão (formato exato do protocolo)
+// Sessão do cliente (APENAS informações de conexão e pontuação).
+// Cada sessão ocupa a sua própria linha de cache: a pontuação é publicada
+// pelo motor a cada tick sem locks e lida pelo top5 sem bloquear ninguém.
 typedef struct {
-    char req_pipe_path[40];
-    char notif_pipe_path[40];
-    int client_id;
-} connection_request_t;
+    _Alignas(64) _Atomic int points;    // Pontuação atual do cliente (para top5)
+    _Atomic int active;                 // publicado depois de client_id/points
+    _Atomic int client_id;
+    int req_fd;
+    int notif_fd;
+} client_session_t;
 
-// Buffer produtor-consumidor
-typedef struct {
-    connection_request_t *buffer;
-    int size;
-    int in;
-    int out;
-    pthread_mutex_t mutex;
-    sem_t empty;
-    sem_t full;
-} request_buffer_t;
-
-// Sessão do cliente (APENAS informações de conexão e pontuação)
+// Canal de notificações de uma sessão (fd não bloqueante): guarda o último
+// tabuleiro enviado para poder mandar só as células alteradas
+// (OP_CODE_BOARD_DELTA) e uma fila de saída limitada a duas frames: a que
+// está a ser escrita e o estado mais recente à espera (substituído a cada tick)
 typedef struct {
-    int client_id;
+    int fd;
+    char* last_frame;       // tabuleiro que o cliente terá depois das frames na fila
+    int last_width;
+    int last_height;
+    int frames_since_keyframe;
+    int need_keyframe;
+    char* frame_buf;        // frame em envio (opcode + cabeçalho + dados)
+    int frame_cap;
+    int frame_len;          // 0: nada em envio
+    int frame_off;          // bytes de frame_buf já escritos
+    char* next_buf;         // keyframe à espera (só quando frame_buf está ocupado)
+    int next_cap;
+    int next_len;           // 0: nada à espera
+    int stalled;            // última escrita deu EAGAIN
+    struct timespec stalled_since;
+    int broken;             // cliente desapareceu ou foi desligado: não escrever mais
+    // TRANSPORT_SHM: as frames vão para o anel (completas) e não para o fd;
+    // frame_buf guarda a última que não coube enquanto o cliente não liberta
+    shm_producer_t* ring;
+    char shm_name[SHM_NAME_LENGTH];
+    // Canal multiplexado: cada frame leva o prefixo OP_CODE_MUX | mux_id
+    // (-1 com um canal só da sessão)
+    int mux_id;
+} notif_stream_t;
+
+// Canal multiplexado (ver OP_CODE_MUX): uma thread lê os pedidos de todas as
+// sessões e entrega-os aos respetivos slots; cada sessão escreve as suas
+// frames (datagramas inteiros) numa cópia do fd de notificações
+typedef struct mux_conn {
     int req_fd;
     int notif_fd;
-    int active;
-    int points;           // Pontuação atual do cliente (para top5)
-    pthread_t game_thread;
-} client_session_t;
+    int client_id;
+    pthread_mutex_t lock;
+    int* slot_of;           // session_id -> slot (MUX_SLOT_FREE / MUX_SLOT_PENDING)
+    int closed;             // o cliente fechou o canal: não abrir mais sessões
+    int refs;               // thread de leitura + pedidos na fila + sessões abertas
+} mux_conn_t;
 
-// Funções do buffer
-void buffer_init(request_buffer_t *buf, int size);
-void buffer_destroy(request_buffer_t *buf);
-void buffer_put(request_buffer_t *buf, connection_request_t req);
-connection_request_t buffer_get(request_buffer_t *buf);
+#define MUX_SLOT_FREE (-1)
+#define MUX_SLOT_PENDING (-2)   // pedido de ligação à espera de um worker
 
 #endif
 
@@ -0,0 +1,54 @@
+#ifndef SESSION_INPUT_H
+#define SESSION_INPUT_H
+
+// Entrada dos clientes: uma thread com epoll lê os FIFOs de pedidos de todas
+// as sessões assim que há dados e guarda os comandos num buffer por sessão
+// (com o instante de chegada). O tick do pacman só consulta esse buffer, de
+// acordo com a política escolhida, e nunca fica atrás do que está no FIFO.
+
+#include "protocol.h"
+
+// Comandos guardados por sessão (-I; um comando repetido conta uma vez).
+// Nunca menos do que MAX_PLAY_BATCH: um lote inteiro tem de caber no buffer,
+// senão as primeiras entradas eram descartadas sem o cliente saber
+#define DEFAULT_INPUT_DEPTH MAX_PLAY_BATCH
+
+typedef enum {
+    INPUT_LATEST = 0,       // só conta a mensagem mais recente (comando ou lote)
+    INPUT_QUEUE = 1,        // fila limitada; cheia, descarta os novos (omissão:
+                            // cada comando jogado pela ordem, como no código base)
+    INPUT_DROP_OLDEST = 2,  // fila limitada; cheia, descarta o mais antigo
+} input_policy_t;
+
+// Resultado de input_next
+enum {
+    INPUT_NONE = 0,         // nada para aplicar neste tick
+    INPUT_COMMAND = 1,
+    INPUT_CLOSED = 2,       // o cliente desligou (OP_CODE_DISCONNECT ou EOF)
+};
+
+// Converte "latest" / "queue" / "drop-oldest"; devolve -1 se desconhecida
+int input_policy_parse(const char* name);
+const char* input_policy_name(int policy);
+
+// Prepara o buffer de n_slots sessões e arranca a thread de leitura (depth
+// abaixo de MAX_PLAY_BATCH sobe para MAX_PLAY_BATCH)
+int input_init(int n_slots, int policy, int depth);
+
+// Começa / deixa de ler o FIFO de pedidos (não bloqueante) do slot.
+// Depois de input_detach a thread já não toca no fd, que pode ser fechado.
+int input_attach(int slot, int fd);
+void input_detach(int slot);
+
+// Sessões de um canal multiplexado: input_attach(slot, -1) e as mensagens
+// (já sem o prefixo OP_CODE_MUX) entregues uma a uma por quem lê o canal
+void input_feed(int slot, const char* msg, int len);
+
+// Comando a aplicar neste tick (regista o tempo desde que chegou). Um
+// comando de um lote com repeat n é devolvido em n ticks seguidos.
+int input_next(int slot, char* command);
+
+// Escreve em stderr a latência entrada -> aplicação e os comandos descartados
+void input_report_stats(void);
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Transporte de tabuleiros por memória partilhada (alternativa ao FIFO de
+// notificações para clientes na mesma máquina). O servidor cria uma região
+// shm_open por sessão com um anel produtor/consumidor único de frames
+// completas; o cliente lê-as no próprio sítio, sem cópias nem syscalls
+// enquanto houver frames. A campainha é um futex partilhado em head.
+
+#define SHM_RING_SLOTS 8            // frames no anel (potência de 2)
+#define SHM_NAME_LENGTH 40
+#define SHM_RING_MAGIC 0x50414331u  // "PAC1"
+
+// Uma frame: o cabeçalho do OP_CODE_BOARD seguido das células (+ '\0')
+typedef struct {
+    int width;
+    int height;
+    int tempo;
+    int victory;
+    int game_over;
+    int points;
+    char data[];
+} shm_frame_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t n_slots;
+    uint32_t slot_stride;           // bytes entre frames consecutivas
+    uint32_t max_cells;
+    // Produtor (servidor)
+    _Alignas(64) _Atomic uint32_t head;     // frames publicadas (palavra do futex)
+    _Atomic uint32_t closed;                // a sessão terminou: não há mais frames
+    _Atomic uint32_t consumer_waiting;      // o cliente está a dormir no futex
+    // Consumidor (cliente)
+    _Alignas(64) _Atomic uint32_t tail;     // frames já libertadas pelo cliente
+    uint32_t next_read;                     // próxima frame a entregar (só o cliente)
+    _Alignas(64) char slots[];
+} shm_ring_t;
+
+// ---- Servidor ----
+
+// O cliente mapeia a região com escrita: o servidor nunca confia na geometria
+// nem no head que lá estão. Usa SHM_RING_SLOTS, o stride que ele próprio
+// calculou e o seu head privado; da região só lê tail (limitado ao que pode
+// verificar).
+typedef struct {
+    shm_ring_t* shared;
+    size_t size;
+    uint32_t slot_stride;
+    uint32_t head;                  // frames publicadas (cópia de confiança)
+} shm_producer_t;
+
+// Cria e mapeia a região name para frames até max_cells células
+shm_producer_t* shm_ring_create(const char* name, int max_cells);
+
+// Frame livre para escrever, ou NULL se o cliente ainda não libertou nenhuma
+shm_frame_t* shm_ring_reserve(shm_producer_t* ring);
+
+// Publica a frame reservada e acorda o cliente se estiver à espera
+void shm_ring_publish(shm_producer_t* ring);
+
+// Marca o fim da sessão (o cliente vê game over depois da última frame)
+void shm_ring_close(shm_producer_t* ring);
+
+// Desfaz o mapeamento e liberta o handle
+void shm_ring_destroy(shm_producer_t* ring);
+
+// ---- Cliente ----
+
+// Mapeia a região criada pelo servidor e remove o nome (fica só o mapeamento)
+shm_ring_t* shm_ring_attach(const char* name, size_t* size);
+
+// Próxima frame por ler; se não houver, espera até timeout_ms por uma.
+// Devolve NULL sem frame (*closed indica se o servidor já terminou).
+shm_frame_t* shm_ring_next(shm_ring_t* ring, int timeout_ms, int* closed);
+
+// Acorda um shm_ring_next à espera noutra thread (devolve NULL)
+void shm_ring_wake(shm_ring_t* ring);
+
+// Liberta a frame mais antiga entregue por shm_ring_next (pela mesma ordem)
+void shm_ring_release(shm_ring_t* ring);
+
+// ---- Ambos ----
+
+void shm_ring_unmap(shm_ring_t* ring, size_t size);
+
+#endif
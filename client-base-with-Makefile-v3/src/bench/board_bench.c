@@ -0,0 +1,151 @@
+// Benchmark da representação do tabuleiro: memória ocupada pelas células,
+// custo de instanciar/descarregar um nível (load_level_from/unload_level) e
+// débito dos movimentos, num tabuleiro 256x256 com 25 fantasmas.
+// O mesmo código é compilado para as duas representações (board_bench e
+// board_bench_compact, ver board.h).
+//
+// Uso: board_bench [rondas_load] [ticks]
+
+#include "board.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_SIZE 256
+#define BENCH_GHOSTS 25
+#define DEFAULT_LOADS 200
+#define DEFAULT_TICKS 20000
+
+#ifdef BOARD_COMPACT
+#define LAYOUT_NAME "compact"
+#else
+#define LAYOUT_NAME "board_pos_t"
+#endif
+
+static double elapsed_s(const struct timespec* a, const struct timespec* b) {
+    return (b->tv_sec - a->tv_sec) + (b->tv_nsec - a->tv_nsec) / 1e9;
+}
+
+// Nível sintético: paredes no contorno e em algumas linhas, pontos no resto,
+// o pacman e fantasmas a andar ao calhas (alguns com carga)
+static int build_level(board_t* level) {
+    memset(level, 0, sizeof(board_t));
+    level->width = BENCH_SIZE;
+    level->height = BENCH_SIZE;
+    level->tempo = 100;
+    level->n_pacmans = 1;
+    level->n_ghosts = BENCH_GHOSTS;
+    strcpy(level->level_name, "bench");
+
+    level->pacmans = calloc(1, sizeof(pacman_t));
+    level->ghosts = calloc(BENCH_GHOSTS, sizeof(ghost_t));
+    if (board_alloc_cells(level) < 0 || !level->pacmans || !level->ghosts) return -1;
+
+    for (int y = 0; y < BENCH_SIZE; y++) {
+        for (int x = 0; x < BENCH_SIZE; x++) {
+            int index = y * BENCH_SIZE + x;
+            if (x == 0 || y == 0 || x == BENCH_SIZE - 1 || y == BENCH_SIZE - 1 ||
+                (y % 10 == 0 && x % 9 != 0)) {
+                board_set_content(level, index, 'W');
+            } else {
+                board_set_content(level, index, ' ');
+                board_set_dot(level, index, 1);
+                level->n_dots++;
+            }
+        }
+    }
+
+    pacman_t* pac = &level->pacmans[0];
+    pac->pos_x = 1;
+    pac->pos_y = 1;
+    pac->alive = 1;
+    pac->n_moves = 1;
+    pac->moves[0].command = 'R';
+    pac->moves[0].turns = 1;
+    board_set_content(level, 1 * BENCH_SIZE + 1, 'P');
+
+    for (int g = 0; g < BENCH_GHOSTS; g++) {
+        ghost_t* ghost = &level->ghosts[g];
+        ghost->pos_x = 3 + (g % 5) * 50;
+        ghost->pos_y = 5 + (g / 5) * 50;
+        ghost->n_moves = 4;
+        for (int m = 0; m < ghost->n_moves; m++) {
+            ghost->moves[m].command = (g % 4 == 0 && m == 0) ? 'C' : 'R';
+            ghost->moves[m].turns = 1;
+        }
+        board_set_content(level, ghost->pos_y * BENCH_SIZE + ghost->pos_x, 'M');
+    }
+    return board_display_rebuild(level);
+}
+
+// Um tick: o pacman (se vivo) e todos os fantasmas tentam mexer-se
+static int tick(board_t* board) {
+    int moves = 0;
+    command_t cmd;
+    cmd.turns = 1;
+    cmd.turns_left = 1;
+
+    if (board->pacmans[0].alive) {
+        cmd.command = 'R';
+        move_pacman(board, 0, &cmd);
+        moves++;
+    }
+    for (int g = 0; g < board->n_ghosts; g++) {
+        ghost_t* ghost = &board->ghosts[g];
+        cmd.command = ghost->moves[ghost->current_move % ghost->n_moves].command;
+        move_ghost(board, g, &cmd);
+        moves++;
+    }
+    return moves;
+}
+
+int main(int argc, char** argv) {
+    int loads = argc > 1 ? atoi(argv[1]) : DEFAULT_LOADS;
+    int ticks = argc > 2 ? atoi(argv[2]) : DEFAULT_TICKS;
+    if (loads <= 0) loads = DEFAULT_LOADS;
+    if (ticks <= 0) ticks = DEFAULT_TICKS;
+
+    board_t level, board;
+    if (build_level(&level) < 0) {
+        fprintf(stderr, "Erro ao construir o tabuleiro\n");
+        return 1;
+    }
+
+    int cells = level.width * level.height;
+    size_t bytes = board_cells_bytes(&level);
+    printf("representação: %s  tabuleiro: %dx%d  fantasmas: %d\n",
+           LAYOUT_NAME, level.width, level.height, level.n_ghosts);
+    printf("células: %zu bytes (%.2f bytes/célula)\n", bytes, (double)bytes / cells);
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < loads; i++) {
+        if (load_level_from(&board, &level, 0) < 0) {
+            fprintf(stderr, "Erro ao instanciar o nível\n");
+            return 1;
+        }
+        unload_level(&board);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    printf("load+unload: %.1f us/nível\n", elapsed_s(&t0, &t1) * 1e6 / loads);
+
+    srand(1);
+    if (load_level_from(&board, &level, 0) < 0) return 1;
+    long moves = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int t = 0; t < ticks; t++) {
+        moves += tick(&board);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double secs = elapsed_s(&t0, &t1);
+    printf("movimentos: %ld em %.3f s (%.1f M/s)\n", moves, secs,
+           secs > 0 ? moves / secs / 1e6 : 0.0);
+
+    unload_level(&board);
+    board_free_cells(&level);
+    free(level.display);
+    free(level.pacmans);
+    free(level.ghosts);
+    return 0;
+}
@@ -0,0 +1,137 @@
+// Benchmark da renderização do tabuleiro: compara a reconstrução completa
+// (fill_board_displayed, O(células x fantasmas)) com o buffer mantido pelos
+// movimentos (board->display), num tabuleiro 100x100 com 25 fantasmas.
+// Em cada tick todos os fantasmas mexem-se e produz-se uma frame por cada
+// caminho; as duas frames são comparadas para validar o buffer incremental.
+//
+// Uso: display_bench [ticks]
+
+#include "board.h"
+#include "display.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_SIZE 100
+#define BENCH_GHOSTS 25
+#define DEFAULT_TICKS 20000
+
+static double elapsed_ns(const struct timespec* a, const struct timespec* b) {
+    return (b->tv_sec - a->tv_sec) * 1e9 + (b->tv_nsec - a->tv_nsec);
+}
+
+// Nível sintético: paredes no contorno e em algumas linhas, pontos no resto,
+// um portal, o pacman parado e fantasmas a andar ao calhas (alguns com carga)
+static int build_level(board_t* level) {
+    memset(level, 0, sizeof(board_t));
+    level->width = BENCH_SIZE;
+    level->height = BENCH_SIZE;
+    level->tempo = 100;
+    level->n_pacmans = 1;
+    level->n_ghosts = BENCH_GHOSTS;
+    strcpy(level->level_name, "bench");
+
+    level->pacmans = calloc(1, sizeof(pacman_t));
+    level->ghosts = calloc(BENCH_GHOSTS, sizeof(ghost_t));
+    if (board_alloc_cells(level) < 0 || !level->pacmans || !level->ghosts) return -1;
+
+    for (int y = 0; y < BENCH_SIZE; y++) {
+        for (int x = 0; x < BENCH_SIZE; x++) {
+            int index = y * BENCH_SIZE + x;
+            if (x == 0 || y == 0 || x == BENCH_SIZE - 1 || y == BENCH_SIZE - 1 ||
+                (y % 10 == 0 && x % 9 != 0)) {
+                board_set_content(level, index, 'W');
+            } else {
+                board_set_content(level, index, ' ');
+                board_set_dot(level, index, 1);
+            }
+        }
+    }
+    board_set_portal(level, (BENCH_SIZE / 2 + 1) * BENCH_SIZE + BENCH_SIZE / 2, 1);
+
+    pacman_t* pac = &level->pacmans[0];
+    pac->pos_x = 1;
+    pac->pos_y = 1;
+    pac->alive = 1;
+    board_set_content(level, 1 * BENCH_SIZE + 1, 'P');
+
+    for (int g = 0; g < BENCH_GHOSTS; g++) {
+        ghost_t* ghost = &level->ghosts[g];
+        ghost->pos_x = 3 + (g % 5) * 19;
+        ghost->pos_y = 5 + (g / 5) * 20;
+        ghost->n_moves = 4;
+        for (int m = 0; m < ghost->n_moves; m++) {
+            ghost->moves[m].command = (g % 4 == 0 && m == 0) ? 'C' : 'R';
+            ghost->moves[m].turns = 1;
+        }
+        board_set_content(level, ghost->pos_y * BENCH_SIZE + ghost->pos_x, 'M');
+    }
+    return 0;
+}
+
+static void move_ghosts(board_t* board) {
+    for (int g = 0; g < board->n_ghosts; g++) {
+        ghost_t* ghost = &board->ghosts[g];
+        command_t cmd;
+        cmd.command = ghost->moves[ghost->current_move % ghost->n_moves].command;
+        cmd.turns = 1;
+        cmd.turns_left = 1;
+        move_ghost(board, g, &cmd);
+    }
+}
+
+int main(int argc, char** argv) {
+    int ticks = argc > 1 ? atoi(argv[1]) : DEFAULT_TICKS;
+    if (ticks <= 0) ticks = DEFAULT_TICKS;
+
+    board_t level, board;
+    if (build_level(&level) < 0 || load_level_from(&board, &level, 0) < 0) {
+        fprintf(stderr, "Erro ao construir o tabuleiro\n");
+        return 1;
+    }
+
+    int cells = board.width * board.height;
+    char* full = malloc(cells);
+    char* incremental = malloc(cells);
+    if (!full || !incremental) return 1;
+
+    srand(1);
+    double full_ns = 0, incremental_ns = 0;
+    int mismatches = 0;
+    struct timespec t0, t1;
+
+    for (int t = 0; t < ticks; t++) {
+        move_ghosts(&board);
+
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        fill_board_displayed(&board, full);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        full_ns += elapsed_ns(&t0, &t1);
+
+        // O servidor usa board->display diretamente; a cópia mede o pior caso
+        // (um keyframe a copiar o tabuleiro inteiro)
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        memcpy(incremental, board.display, cells);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        incremental_ns += elapsed_ns(&t0, &t1);
+
+        if (memcmp(full, incremental, cells) != 0) mismatches++;
+    }
+
+    printf("tabuleiro: %dx%d  fantasmas: %d  ticks: %d\n",
+           board.width, board.height, board.n_ghosts, ticks);
+    printf("reconstrução completa: %8.0f ns/frame\n", full_ns / ticks);
+    printf("buffer incremental:    %8.0f ns/frame  (%.1fx)\n", incremental_ns / ticks,
+           incremental_ns > 0 ? full_ns / incremental_ns : 0.0);
+    printf("frames diferentes: %d\n", mismatches);
+
+    unload_level(&board);
+    board_free_cells(&level);
+    free(level.display);
+    free(level.pacmans);
+    free(level.ghosts);
+    free(full);
+    free(incremental);
+    return mismatches != 0;
+}
@@ -0,0 +1,128 @@
+// Verificação do buffer de entrada do servidor (session_input.c): um lote
+// OP_CODE_PLAY_BATCH com MAX_PLAY_BATCH entradas escrito num FIFO tem de ser
+// jogado inteiro e pela ordem certa, com cada política de entrada e com o
+// menor -I pedido. Cada política corre num processo filho (o módulo tem
+// estado global e uma thread de leitura). Mostra também quanto demora cada
+// input_next.
+//
+// Uso: input_bench [-I]
+
+#include "session_input.h"
+#include "protocol.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/wait.h>
+
+#define TIMEOUT_MS 2000
+
+// Lote de teste: comandos alternados, alguns repetidos (como "T n")
+static int build_batch(char* msg, char* expected, int* n_expected) {
+    static const char moves[] = "WASD";
+    int n = MAX_PLAY_BATCH;
+    msg[0] = OP_CODE_PLAY_BATCH;
+    memcpy(msg + 1, &n, sizeof(int));
+
+    *n_expected = 0;
+    char* entry = msg + PLAY_BATCH_HEADER_SIZE;
+    for (int i = 0; i < n; i++, entry += PLAY_BATCH_ENTRY_SIZE) {
+        int repeat = i % 5 == 0 ? 2 : 1;
+        entry[0] = moves[i % 4];
+        memcpy(entry + 1, &repeat, sizeof(int));
+        for (int r = 0; r < repeat; r++) expected[(*n_expected)++] = moves[i % 4];
+    }
+    return PLAY_BATCH_HEADER_SIZE + n * PLAY_BATCH_ENTRY_SIZE;
+}
+
+static double elapsed_ms(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1e3 + (now.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+// Corre no processo filho: devolve 0 se o lote foi jogado inteiro
+static int check_policy(int policy, int depth) {
+    int fds[2];
+    if (pipe(fds) == -1 || fcntl(fds[0], F_SETFL, O_NONBLOCK) == -1) {
+        perror("Erro ao criar pipe");
+        return 1;
+    }
+    if (input_init(1, policy, depth) < 0 || input_attach(0, fds[0]) < 0) {
+        fprintf(stderr, "Erro ao iniciar a entrada\n");
+        return 1;
+    }
+
+    char msg[PLAY_BATCH_HEADER_SIZE + MAX_PLAY_BATCH * PLAY_BATCH_ENTRY_SIZE];
+    char expected[2 * MAX_PLAY_BATCH], played[2 * MAX_PLAY_BATCH];
+    int n_expected;
+    int len = build_batch(msg, expected, &n_expected);
+    if (write(fds[1], msg, len) != len) {
+        perror("Erro ao escrever o lote");
+        return 1;
+    }
+
+    // A thread de leitura entrega o lote quando o epoll o vir
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int n_played = 0;
+    double next_ns = 0;
+    while (n_played < n_expected && elapsed_ms(&start) < TIMEOUT_MS) {
+        struct timespec t0, t1;
+        char command;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        int result = input_next(0, &command);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        if (result == INPUT_COMMAND) {
+            next_ns += (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+            played[n_played++] = command;
+        } else if (result == INPUT_CLOSED) {
+            break;
+        } else {
+            struct timespec pause = {0, 100000};
+            nanosleep(&pause, NULL);
+        }
+    }
+
+    // Não há mais nada: um comando a mais também seria um erro
+    char extra;
+    int leftover = input_next(0, &extra) == INPUT_COMMAND;
+    int ok = n_played == n_expected && !leftover && memcmp(played, expected, n_expected) == 0;
+
+    printf("%-12s -I %-3d %3d/%d comandos jogados%s  %6.1f ns/input_next  %s\n",
+           input_policy_name(policy), depth, n_played, n_expected,
+           leftover ? " (+ a mais)" : "", n_played ? next_ns / n_played : 0.0,
+           ok ? "OK" : "FALHOU");
+    input_detach(0);
+    close(fds[0]);
+    close(fds[1]);
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    // Por omissão o menor -I possível: o buffer tem de subir para um lote
+    int depth = argc > 1 ? atoi(argv[1]) : 1;
+
+    int failures = 0;
+    for (int policy = INPUT_LATEST; policy <= INPUT_DROP_OLDEST; policy++) {
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == -1) {
+            perror("Erro no fork");
+            return 1;
+        }
+        if (pid == 0) {
+            int rc = check_policy(policy, depth);
+            fflush(stdout);     // _exit não esvazia o stdio
+            _exit(rc);
+        }
+
+        int status;
+        if (waitpid(pid, &status, 0) == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            failures++;
+        }
+    }
+    return failures != 0;
+}
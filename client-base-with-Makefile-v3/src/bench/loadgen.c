@@ -0,0 +1,669 @@
+// Gerador de carga sintética para o Pacmanist: abre muitas sessões por FIFO
+// (OP_CODE_CONNECT pelo FIFO de registo, com o código real de api.c), joga
+// comandos ao calhas ou de um guião e consome as frames de cada sessão.
+// Serve para pôr à prova a thread anfitriã, o request_buffer e o conjunto de
+// sessões, e para encontrar o ponto a partir do qual max_games deixa de
+// escalar.
+//
+// As chegadas seguem um perfil:
+//   burst   todas as sessões ao mesmo tempo
+//   steady  taxa constante de -r ligações/s
+//   ramp    taxa a subir linearmente de 0 até -r ligações/s
+//
+// A latência de ligação conta desde a hora agendada para a chegada (não desde
+// o início do connect), para não esconder o atraso quando todas as threads de
+// ligação estão bloqueadas. O servidor só responde quando há um slot livre:
+// uma ligação que demorou mais do que -q ms esteve em fila.
+//
+// Uso: loadgen [-n sessões] [-a burst|ramp|steady] [-r ligações/s]
+//              [-l segundos] [-t ms_por_jogada] [-s guião] [-c ligadores]
+//              [-d condutores] [-q ms] [-i primeiro_id] [-p pid_servidor]
+//              <register_pipe>
+
+#include "api.h"
+#include "protocol.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <math.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#define DEFAULT_SESSIONS 100
+#define DEFAULT_RATE 50.0           // ligações/s (steady e ramp)
+#define DEFAULT_HOLD_S 10
+#define DEFAULT_PLAY_MS 100
+#define DEFAULT_CONNECTORS 64
+#define DEFAULT_DRIVERS 2
+#define DEFAULT_QUEUED_MS 10
+#define DEFAULT_FIRST_ID 10000
+#define MAX_POLL_MS 100
+#define MIN_RATE_LIFETIME_NS 1000000000LL
+
+enum { PROFILE_BURST, PROFILE_STEADY, PROFILE_RAMP };
+static const char* profile_names[] = {"burst", "steady", "ramp"};
+
+enum { LG_PENDING, LG_CONNECTING, LG_REJECTED, LG_ACTIVE, LG_DONE };
+
+// ==================== ESTADO ====================
+
+typedef struct {
+    int id;                     // client_id (nome dos FIFOs)
+    long long arrival_ns;       // chegada agendada, desde o início
+    pacman_session_t* s;
+    _Atomic int state;
+    long long connect_ns;       // chegada agendada -> resposta do servidor
+    long long connected_ns;
+    long long ended_ns;
+    long frames;
+    long plays;
+    int ended_by_server;        // o jogo acabou (ou o servidor fechou)
+    int script_pos;
+    long long next_play_ns;
+} lg_session_t;
+
+// Cada condutor trata das sessões já ligadas que lhe calham: espera pelas
+// frames de todas com um poll e manda as jogadas quando chega a hora
+typedef struct {
+    pthread_t tid;
+    pthread_mutex_t lock;
+    int* incoming;              // sessões ligadas ainda por adotar
+    int n_incoming;
+    int cap_incoming;
+    int wake[2];                // acorda o poll quando chega uma sessão
+    unsigned seed;
+} lg_driver_t;
+
+static struct {
+    int n_sessions;
+    int profile;
+    double rate;
+    int hold_s;                 // 0: até o jogo acabar
+    int play_ms;
+    char* script;               // NULL: comandos ao calhas
+    int script_len;
+    int n_connectors;
+    int n_drivers;
+    int queued_ms;
+    int first_id;
+    int server_pid;             // 0: sem medição de CPU do servidor
+    char register_pipe[MAX_PIPE_PATH_LENGTH];
+} cfg;
+
+static lg_session_t* sessions;
+static lg_driver_t* drivers;
+static struct timespec start;
+
+static atomic_int next_arrival;
+static atomic_bool connectors_done;
+static atomic_bool stop_requested;
+static atomic_int n_connecting;
+static atomic_int n_connected;
+static atomic_int n_rejected;
+static atomic_int n_active;
+static atomic_long total_frames;
+static atomic_long total_plays;
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec - start.tv_sec) * 1000000000LL + (ts.tv_nsec - start.tv_nsec);
+}
+
+static void sleep_until_ns(long long t) {
+    struct timespec ts = start;
+    ts.tv_sec += t / 1000000000LL;
+    ts.tv_nsec += t % 1000000000LL;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+        if (atomic_load(&stop_requested)) return;
+    }
+}
+
+static void stop_handler(int sig) {
+    (void)sig;
+    atomic_store(&stop_requested, true);
+}
+
+// ==================== PERFIS DE CHEGADA ====================
+
+static void schedule_arrivals(void) {
+    for (int i = 0; i < cfg.n_sessions; i++) {
+        double t = 0;
+        if (cfg.profile == PROFILE_STEADY) {
+            t = i / cfg.rate;
+        } else if (cfg.profile == PROFILE_RAMP) {
+            // Taxa rate * t / T com T = 2n / rate: chegam n sessões em T e a
+            // i-ésima chega quando rate * t² / (2T) = i
+            t = 2.0 * sqrt((double)i * cfg.n_sessions) / cfg.rate;
+        }
+        sessions[i].id = cfg.first_id + i;
+        sessions[i].arrival_ns = (long long)(t * 1e9);
+        sessions[i].state = LG_PENDING;
+    }
+}
+
+// ==================== LIGAÇÃO ====================
+
+static void driver_adopt(lg_driver_t* d, int idx) {
+    pthread_mutex_lock(&d->lock);
+    if (d->n_incoming == d->cap_incoming) {
+        int cap = d->cap_incoming ? 2 * d->cap_incoming : 64;
+        int* grown = realloc(d->incoming, cap * sizeof(int));
+        if (!grown) {
+            pthread_mutex_unlock(&d->lock);
+            pacman_session_disconnect(sessions[idx].s);
+            sessions[idx].state = LG_DONE;
+            atomic_fetch_sub(&n_active, 1);
+            return;
+        }
+        d->incoming = grown;
+        d->cap_incoming = cap;
+    }
+    d->incoming[d->n_incoming++] = idx;
+    pthread_mutex_unlock(&d->lock);
+
+    char byte = 0;
+    if (write(d->wake[1], &byte, 1) < 0 && errno != EAGAIN) perror("Erro ao acordar condutor");
+}
+
+static void* connector_thread(void* arg) {
+    (void)arg;
+    char req[MAX_PIPE_PATH_LENGTH], notif[MAX_PIPE_PATH_LENGTH];
+    int uid = (int)getuid();
+
+    int i;
+    while ((i = atomic_fetch_add(&next_arrival, 1)) < cfg.n_sessions) {
+        lg_session_t* ls = &sessions[i];
+        sleep_until_ns(ls->arrival_ns);
+        if (atomic_load(&stop_requested)) break;
+
+        // Mesmo formato de nomes que o cliente (o servidor tira daqui o id)
+        snprintf(req, sizeof(req), "/tmp/%d_%d_lgrequest", uid, ls->id);
+        snprintf(notif, sizeof(notif), "/tmp/%d_%d_lgnotif", uid, ls->id);
+
+        ls->state = LG_CONNECTING;
+        atomic_fetch_add(&n_connecting, 1);
+        ls->s = pacman_session_connect(req, notif, cfg.register_pipe, TRANSPORT_PIPE);
+        long long t = now_ns();
+        atomic_fetch_sub(&n_connecting, 1);
+        ls->connect_ns = t - ls->arrival_ns;
+
+        if (!ls->s) {
+            ls->state = LG_REJECTED;
+            atomic_fetch_add(&n_rejected, 1);
+            continue;
+        }
+        ls->connected_ns = t;
+        ls->state = LG_ACTIVE;
+        atomic_fetch_add(&n_connected, 1);
+        atomic_fetch_add(&n_active, 1);
+        driver_adopt(&drivers[i % cfg.n_drivers], i);
+    }
+    return NULL;
+}
+
+// ==================== CONDUÇÃO DAS SESSÕES ====================
+
+static char next_command(lg_driver_t* d, lg_session_t* ls) {
+    static const char moves[] = "WASD";
+    if (!cfg.script) return moves[rand_r(&d->seed) % 4];
+    char c = cfg.script[ls->script_pos];
+    ls->script_pos = (ls->script_pos + 1) % cfg.script_len;
+    return c;
+}
+
+static void session_end(lg_session_t* ls, long long t, int by_server) {
+    ls->ended_ns = t;
+    ls->ended_by_server = by_server;
+    pacman_session_disconnect(ls->s);
+    ls->s = NULL;
+    ls->state = LG_DONE;
+    atomic_fetch_sub(&n_active, 1);
+}
+
+// Consome todas as frames que já chegaram; devolve 1 se a sessão acabou
+static int session_drain(lg_session_t* ls, Board* board) {
+    long frames = 0;
+    int result;
+    while ((result = pacman_session_receive_into(ls->s, board, 0)) == RECEIVE_BOARD) {
+        frames++;
+    }
+    ls->frames += frames;
+    atomic_fetch_add(&total_frames, frames);
+    return result == RECEIVE_CLOSED;
+}
+
+static void* driver_thread(void* arg) {
+    lg_driver_t* d = arg;
+    int n = 0, cap = 64;
+    int* active = malloc(cap * sizeof(int));
+    struct pollfd* pfds = malloc((cap + 1) * sizeof(struct pollfd));  // + wake
+    Board board = {0};
+    if (!active || !pfds) {
+        perror("Erro ao reservar memória do condutor");
+        exit(1);
+    }
+
+    while (1) {
+        // Adotar as sessões que os ligadores entregaram entretanto
+        pthread_mutex_lock(&d->lock);
+        if (n + d->n_incoming > cap) {
+            int new_cap = cap;
+            while (new_cap < n + d->n_incoming) new_cap *= 2;
+            int* grown_active = realloc(active, new_cap * sizeof(int));
+            if (grown_active) active = grown_active;
+            struct pollfd* grown_pfds = realloc(pfds, (new_cap + 1) * sizeof(struct pollfd));
+            if (grown_pfds) pfds = grown_pfds;
+            if (grown_active && grown_pfds) cap = new_cap;
+        }
+        long long t = now_ns();
+        int adopted = 0;
+        for (; adopted < d->n_incoming && n < cap; adopted++) {
+            int idx = d->incoming[adopted];
+            sessions[idx].next_play_ns = t;
+            sessions[idx].script_pos = cfg.script ? sessions[idx].id % cfg.script_len : 0;
+            active[n++] = idx;
+        }
+        memmove(d->incoming, d->incoming + adopted, (d->n_incoming - adopted) * sizeof(int));
+        d->n_incoming -= adopted;
+        int waiting = d->n_incoming;
+        pthread_mutex_unlock(&d->lock);
+
+        if (n == 0 && waiting == 0 && atomic_load(&connectors_done)) break;
+
+        // Esperar por frames até à próxima jogada (ou pela próxima sessão)
+        long long next = t + MAX_POLL_MS * 1000000LL;
+        for (int i = 0; i < n; i++) {
+            lg_session_t* ls = &sessions[active[i]];
+            if (ls->next_play_ns < next) next = ls->next_play_ns;
+            pfds[i].fd = pacman_session_fd(ls->s);
+            pfds[i].events = POLLIN;
+            pfds[i].revents = 0;
+        }
+        pfds[n].fd = d->wake[0];
+        pfds[n].events = POLLIN;
+        pfds[n].revents = 0;
+
+        int timeout = next > t ? (int)((next - t + 999999) / 1000000) : 0;
+        if (poll(pfds, n + 1, timeout) < 0 && errno != EINTR) {
+            perror("Erro no poll do condutor");
+            break;
+        }
+        if (pfds[n].revents & POLLIN) {
+            char drain[64];
+            while (read(d->wake[0], drain, sizeof(drain)) > 0) {
+            }
+        }
+
+        t = now_ns();
+        int stopping = atomic_load(&stop_requested);
+        for (int i = 0; i < n; i++) {
+            lg_session_t* ls = &sessions[active[i]];
+            int ended = (pfds[i].revents & (POLLIN | POLLHUP | POLLERR)) && session_drain(ls, &board);
+
+            if (!ended && !stopping && t >= ls->next_play_ns) {
+                pacman_session_play(ls->s, next_command(d, ls));
+                ls->plays++;
+                atomic_fetch_add(&total_plays, 1);
+                // Atrasado (poll lento): não tentar recuperar as jogadas perdidas
+                ls->next_play_ns += cfg.play_ms * 1000000LL;
+                if (ls->next_play_ns < t) ls->next_play_ns = t + cfg.play_ms * 1000000LL;
+            }
+
+            int expired = cfg.hold_s > 0 && t - ls->connected_ns >= cfg.hold_s * 1000000000LL;
+            if (ended || expired || stopping) {
+                session_end(ls, t, ended);
+                // pfds[i] já não é usado nesta volta: trocar pela última
+                active[i] = active[n - 1];
+                pfds[i] = pfds[n - 1];
+                n--;
+                i--;
+            }
+        }
+    }
+
+    release_board(&board);
+    free(active);
+    free(pfds);
+    return NULL;
+}
+
+// ==================== MEDIÇÃO ====================
+
+// Tempo de CPU (utime + stime) de um processo em segundos, ou -1
+static double process_cpu_s(int pid) {
+    char path[64], buf[1024];
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    FILE* f = fopen(path, "r");
+    if (!f) return -1;
+    size_t len = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    buf[len] = '\0';
+
+    // O nome (campo 2) pode ter espaços: os campos seguem o último ')'
+    char* p = strrchr(buf, ')');
+    if (!p) return -1;
+    unsigned long utime, stime;
+    if (sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+               &utime, &stime) != 2) {
+        return -1;
+    }
+    return (double)(utime + stime) / sysconf(_SC_CLK_TCK);
+}
+
+static double own_cpu_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int cmp_ll(const void* a, const void* b) {
+    long long x = *(const long long*)a, y = *(const long long*)b;
+    return (x > y) - (x < y);
+}
+
+static int cmp_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Linha de um segundo: permite ver onde as ligações começam a esperar
+static void report_tick(long long t, int* last_connected, long* last_frames,
+                        double* last_cpu, double* peak_cpu) {
+    int connected = atomic_load(&n_connected);
+    long frames = atomic_load(&total_frames);
+    printf("t=%5.1fs  ligadas %6d (+%4d)  a ligar %5d  recusadas %4d  ativas %6d  frames/s %8ld",
+           t / 1e9, connected, connected - *last_connected, atomic_load(&n_connecting),
+           atomic_load(&n_rejected), atomic_load(&n_active), frames - *last_frames);
+    *last_connected = connected;
+    *last_frames = frames;
+
+    if (cfg.server_pid > 0) {
+        double cpu = process_cpu_s(cfg.server_pid);
+        if (cpu >= 0 && *last_cpu >= 0) {
+            double pct = (cpu - *last_cpu) * 100.0;
+            if (pct > *peak_cpu) *peak_cpu = pct;
+            printf("  CPU servidor %5.1f%%", pct);
+        }
+        *last_cpu = cpu;
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+static void report_final(double elapsed_s, double server_cpu_s, double peak_cpu) {
+    int n = cfg.n_sessions;
+    long long* connect = malloc(n * sizeof(long long));
+    double* rates = malloc(n * sizeof(double));
+    if (!connect || !rates) {
+        free(connect);
+        free(rates);
+        return;
+    }
+
+    int n_connect = 0, n_rates = 0, queued = 0, by_server = 0;
+    long frames = 0, plays = 0;
+    double rate_sum = 0;
+    for (int i = 0; i < n; i++) {
+        lg_session_t* ls = &sessions[i];
+        if (ls->state != LG_DONE) continue;
+        connect[n_connect++] = ls->connect_ns;
+        if (ls->connect_ns > cfg.queued_ms * 1000000LL) queued++;
+        by_server += ls->ended_by_server;
+        frames += ls->frames;
+        plays += ls->plays;
+        // Sessões muito curtas (ligadas mesmo antes do fim) dão taxas sem sentido
+        long long lifetime = ls->ended_ns - ls->connected_ns;
+        if (lifetime >= MIN_RATE_LIFETIME_NS) {
+            rates[n_rates] = ls->frames * 1e9 / lifetime;
+            rate_sum += rates[n_rates++];
+        }
+    }
+
+    printf("\n=== loadgen: %s (%.1f ligações/s), %d sessões, jogada a cada %d ms ===\n",
+           profile_names[cfg.profile], cfg.profile == PROFILE_BURST ? 0.0 : cfg.rate, n,
+           cfg.play_ms);
+    int launched = atomic_load(&n_connected) + atomic_load(&n_rejected);
+    printf("ligações: %d aceites, %d recusadas/falhadas, %d por lançar; %d em fila (> %d ms)\n",
+           atomic_load(&n_connected), atomic_load(&n_rejected), n - launched, queued,
+           cfg.queued_ms);
+
+    if (n_connect > 0) {
+        qsort(connect, n_connect, sizeof(long long), cmp_ll);
+        printf("latência de ligação aceite (ms): p50 %.2f  p90 %.2f  p99 %.2f  máx %.2f\n",
+               connect[n_connect / 2] / 1e6, connect[(n_connect * 90) / 100] / 1e6,
+               connect[(n_connect * 99) / 100] / 1e6, connect[n_connect - 1] / 1e6);
+    }
+    if (n_rates > 0) {
+        qsort(rates, n_rates, sizeof(double), cmp_double);
+        printf("frames/s por sessão (%d com >= 1 s): média %.2f  p50 %.2f  p10 %.2f  mín %.2f\n",
+               n_rates, rate_sum / n_rates, rates[n_rates / 2], rates[n_rates / 10], rates[0]);
+    }
+    printf("sessões: %d terminadas pelo servidor, %d pelo loadgen; %ld frames, %ld jogadas\n",
+           by_server, n_connect - by_server, frames, plays);
+    printf("duração %.1f s; CPU do loadgen %.1f%%", elapsed_s, own_cpu_s() / elapsed_s * 100.0);
+    if (server_cpu_s >= 0) {
+        printf("; CPU do servidor %.1f%% (pico %.1f%% num segundo)",
+               server_cpu_s / elapsed_s * 100.0, peak_cpu);
+    }
+    printf("\n");
+
+    free(connect);
+    free(rates);
+}
+
+// ==================== ARRANQUE ====================
+
+static int load_script(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        perror("Erro ao abrir o guião");
+        return -1;
+    }
+    int cap = 256, len = 0, c;
+    char* script = malloc(cap);
+    while (script && (c = fgetc(f)) != EOF) {
+        // Só os movimentos: o resto (espaços, 'Q', 'T'...) não se manda
+        if (c != 'W' && c != 'A' && c != 'S' && c != 'D') continue;
+        if (len == cap) {
+            char* grown = realloc(script, cap *= 2);
+            if (!grown) {
+                free(script);
+                script = NULL;
+                break;
+            }
+            script = grown;
+        }
+        script[len++] = (char)c;
+    }
+    fclose(f);
+    if (!script || len == 0) {
+        fprintf(stderr, "O guião %s não tem movimentos (WASD)\n", path);
+        free(script);
+        return -1;
+    }
+    cfg.script = script;
+    cfg.script_len = len;
+    return 0;
+}
+
+// Cada sessão usa 2 FIFOs e um pipe de despertar: sobe o limite de
+// descritores até ao máximo permitido
+static void raise_fd_limit(void) {
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) != 0) return;
+    rl.rlim_cur = rl.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &rl);
+    long needed = 4L * cfg.n_sessions + 2L * cfg.n_drivers + 64;
+    if (rl.rlim_max != RLIM_INFINITY && (long)rl.rlim_max < needed) {
+        fprintf(stderr, "Aviso: limite de %ld descritores, %d sessões podem precisar de %ld\n",
+                (long)rl.rlim_max, cfg.n_sessions, needed);
+    }
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+        "Usage: %s [-n sessions] [-a burst|ramp|steady] [-r connects_per_s] [-l hold_s]\n"
+        "          [-t play_ms] [-s script] [-c connectors] [-d drivers] [-q queued_ms]\n"
+        "          [-i first_id] [-p server_pid] <register_pipe>\n", prog);
+}
+
+int main(int argc, char** argv) {
+    cfg.n_sessions = DEFAULT_SESSIONS;
+    cfg.profile = PROFILE_STEADY;
+    cfg.rate = DEFAULT_RATE;
+    cfg.hold_s = DEFAULT_HOLD_S;
+    cfg.play_ms = DEFAULT_PLAY_MS;
+    cfg.n_connectors = DEFAULT_CONNECTORS;
+    cfg.n_drivers = DEFAULT_DRIVERS;
+    cfg.queued_ms = DEFAULT_QUEUED_MS;
+    cfg.first_id = DEFAULT_FIRST_ID;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:a:r:l:t:s:c:d:q:i:p:")) != -1) {
+        switch (opt) {
+            case 'n': cfg.n_sessions = atoi(optarg); break;
+            case 'a':
+                cfg.profile = -1;
+                for (int p = 0; p < 3; p++) {
+                    if (strcmp(optarg, profile_names[p]) == 0) cfg.profile = p;
+                }
+                break;
+            case 'r': cfg.rate = atof(optarg); break;
+            case 'l': cfg.hold_s = atoi(optarg); break;
+            case 't': cfg.play_ms = atoi(optarg); break;
+            case 's':
+                if (load_script(optarg) < 0) return 1;
+                break;
+            case 'c': cfg.n_connectors = atoi(optarg); break;
+            case 'd': cfg.n_drivers = atoi(optarg); break;
+            case 'q': cfg.queued_ms = atoi(optarg); break;
+            case 'i': cfg.first_id = atoi(optarg); break;
+            case 'p': cfg.server_pid = atoi(optarg); break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (argc - optind != 1 || cfg.n_sessions <= 0 || cfg.profile < 0 || cfg.rate <= 0 ||
+        cfg.hold_s < 0 || cfg.play_ms <= 0 || cfg.n_connectors <= 0 || cfg.n_drivers <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // Mesma convenção do cliente: nome relativo fica em /tmp/<uid>_<nome>
+    const char* reg = argv[optind];
+    if (reg[0] == '/') snprintf(cfg.register_pipe, sizeof(cfg.register_pipe), "%s", reg);
+    else snprintf(cfg.register_pipe, sizeof(cfg.register_pipe), "/tmp/%d_%s", (int)getuid(), reg);
+
+    if (access(cfg.register_pipe, W_OK) != 0) {
+        perror("Erro ao aceder ao FIFO de registo");
+        return 1;
+    }
+    if (cfg.n_connectors > cfg.n_sessions) cfg.n_connectors = cfg.n_sessions;
+
+    signal(SIGPIPE, SIG_IGN);
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = stop_handler;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    raise_fd_limit();
+
+    sessions = calloc(cfg.n_sessions, sizeof(lg_session_t));
+    drivers = calloc(cfg.n_drivers, sizeof(lg_driver_t));
+    pthread_t* connectors = calloc(cfg.n_connectors, sizeof(pthread_t));
+    if (!sessions || !drivers || !connectors) {
+        perror("Erro ao reservar memória");
+        return 1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    schedule_arrivals();
+    double server_cpu_start = cfg.server_pid > 0 ? process_cpu_s(cfg.server_pid) : -1;
+    if (cfg.server_pid > 0 && server_cpu_start < 0) {
+        fprintf(stderr, "Aviso: sem acesso a /proc/%d/stat, CPU do servidor não medido\n",
+                cfg.server_pid);
+        cfg.server_pid = 0;
+    }
+
+    for (int i = 0; i < cfg.n_drivers; i++) {
+        lg_driver_t* d = &drivers[i];
+        pthread_mutex_init(&d->lock, NULL);
+        d->seed = (unsigned)(i + 1);
+        if (pipe(d->wake) == -1 ||
+            fcntl(d->wake[0], F_SETFL, O_NONBLOCK) == -1 ||
+            fcntl(d->wake[1], F_SETFL, O_NONBLOCK) == -1 ||
+            pthread_create(&d->tid, NULL, driver_thread, d) != 0) {
+            perror("Erro ao iniciar condutor");
+            return 1;
+        }
+    }
+    int started = 0;
+    for (; started < cfg.n_connectors; started++) {
+        if (pthread_create(&connectors[started], NULL, connector_thread, NULL) != 0) break;
+    }
+    if (started == 0) {
+        perror("Erro ao iniciar threads de ligação");
+        return 1;
+    }
+
+    printf("loadgen: %d sessões (%s, %.1f ligações/s), %d ligadores, %d condutores -> %s\n",
+           cfg.n_sessions, profile_names[cfg.profile],
+           cfg.profile == PROFILE_BURST ? 0.0 : cfg.rate, started, cfg.n_drivers,
+           cfg.register_pipe);
+
+    // Relatório de segundo a segundo até todas as sessões terminarem
+    int last_connected = 0;
+    long last_frames = 0;
+    double last_cpu = server_cpu_start, peak_cpu = 0;
+    long long tick = 1000000000LL;
+    while (1) {
+        sleep_until_ns(tick);
+        int pending = cfg.n_sessions - atomic_load(&n_connected) - atomic_load(&n_rejected);
+        int finished = atomic_load(&n_active) == 0 &&
+                       (pending == 0 || atomic_load(&next_arrival) >= cfg.n_sessions + started);
+        if (atomic_load(&stop_requested) && atomic_load(&n_connecting) == 0) finished = 1;
+        report_tick(now_ns(), &last_connected, &last_frames, &last_cpu, &peak_cpu);
+        if (finished) break;
+        tick += 1000000000LL;
+    }
+
+    for (int i = 0; i < started; i++) pthread_join(connectors[i], NULL);
+    atomic_store(&connectors_done, true);
+    for (int i = 0; i < cfg.n_drivers; i++) {
+        char byte = 0;
+        if (write(drivers[i].wake[1], &byte, 1) < 0) perror("Erro ao acordar condutor");
+        pthread_join(drivers[i].tid, NULL);
+        close(drivers[i].wake[0]);
+        close(drivers[i].wake[1]);
+        free(drivers[i].incoming);
+        pthread_mutex_destroy(&drivers[i].lock);
+    }
+
+    double elapsed_s = now_ns() / 1e9;
+    double server_cpu = -1;
+    if (cfg.server_pid > 0) {
+        double cpu_end = process_cpu_s(cfg.server_pid);
+        if (cpu_end >= 0) server_cpu = cpu_end - server_cpu_start;
+    }
+    report_final(elapsed_s, server_cpu, peak_cpu);
+
+    free(connectors);
+    free(drivers);
+    free(sessions);
+    free(cfg.script);
+    return 0;
+}
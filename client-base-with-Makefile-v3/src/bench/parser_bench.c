@@ -0,0 +1,152 @@
+// Benchmark do parser de níveis: gera (ou usa) uma diretoria de níveis
+// grandes e mede o débito de read_level/read_pacman/read_ghosts em MB/s.
+//
+// Uso: parser_bench [levels_dir] [rondas]
+
+#include "board.h"
+#include "parser.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#define GEN_LEVELS 16
+#define GEN_SIZE 400
+#define GEN_GHOSTS 4
+#define DEFAULT_ROUNDS 5
+
+// Tamanho de dir/name (ou de name, se dir == NULL)
+static long file_size(const char* dir, const char* name) {
+    char path[MAX_FILENAME * 2];
+    struct stat st;
+    if (dir) snprintf(path, sizeof(path), "%s/%s", dir, name);
+    else snprintf(path, sizeof(path), "%s", name);
+    return stat(path, &st) == 0 ? (long)st.st_size : 0;
+}
+
+// Gera GEN_LEVELS níveis GEN_SIZE x GEN_SIZE (labirinto simples) com pacman
+// e fantasmas
+static int generate_levels(const char* dir) {
+    char path[MAX_FILENAME * 2];
+
+    snprintf(path, sizeof(path), "%s/pacman.p", dir);
+    FILE* f = fopen(path, "w");
+    if (!f) return -1;
+    fprintf(f, "# pacman gerado\nPASSO 0\nPOS 1 1\n");
+    for (int i = 0; i < MAX_MOVES; i++) fprintf(f, i % 5 == 4 ? "T 3\n" : "%c\n", "WASD"[i % 4]);
+    fclose(f);
+
+    for (int g = 0; g < GEN_GHOSTS; g++) {
+        snprintf(path, sizeof(path), "%s/g%d.m", dir, g);
+        f = fopen(path, "w");
+        if (!f) return -1;
+        fprintf(f, "PASSO %d\nPOS %d %d\n", g, GEN_SIZE - 2 - g, GEN_SIZE - 2);
+        for (int i = 0; i < MAX_MOVES; i++) fprintf(f, "%c\n", "WASDRC"[(i + g) % 6]);
+        fclose(f);
+    }
+
+    for (int l = 0; l < GEN_LEVELS; l++) {
+        snprintf(path, sizeof(path), "%s/%02d.lvl", dir, l);
+        f = fopen(path, "w");
+        if (!f) return -1;
+        fprintf(f, "# nível gerado %d\nDIM %d %d\nTEMPO 100\nPAC pacman.p\nMON", l, GEN_SIZE, GEN_SIZE);
+        for (int g = 0; g < GEN_GHOSTS; g++) fprintf(f, " g%d.m", g);
+        fprintf(f, "\n");
+        for (int y = 0; y < GEN_SIZE; y++) {
+            for (int x = 0; x < GEN_SIZE; x++) {
+                char c = 'o';
+                if (x == 0 || y == 0 || x == GEN_SIZE - 1 || y == GEN_SIZE - 1) c = 'X';
+                else if (y % 4 == 0 && (x + l) % 7 != 0) c = 'X';
+                else if (x == GEN_SIZE / 2 && y == GEN_SIZE / 2 + 1) c = '@';
+                fputc(c, f);
+            }
+            fputc('\n', f);
+        }
+        fclose(f);
+    }
+    return 0;
+}
+
+static void remove_dir(const char* dir) {
+    DIR* d = opendir(dir);
+    if (!d) return;
+    struct dirent* e;
+    char path[MAX_FILENAME * 2];
+    while ((e = readdir(d)) != NULL) {
+        if (e->d_name[0] == '.') continue;
+        snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+        unlink(path);
+    }
+    closedir(d);
+    rmdir(dir);
+}
+
+int main(int argc, char** argv) {
+    char gen_dir[] = "/tmp/parser_bench.XXXXXX";
+    char* dir = argc > 1 ? argv[1] : NULL;
+    int rounds = argc > 2 ? atoi(argv[2]) : DEFAULT_ROUNDS;
+    if (rounds <= 0) rounds = DEFAULT_ROUNDS;
+
+    if (!dir) {
+        if (!mkdtemp(gen_dir) || generate_levels(gen_dir) < 0) {
+            perror("Erro ao gerar níveis");
+            return 1;
+        }
+        dir = gen_dir;
+    }
+
+    // Listar os níveis
+    char* names[256];
+    int n = 0;
+    DIR* d = opendir(dir);
+    if (!d) {
+        perror("Erro ao abrir diretoria");
+        return 1;
+    }
+    struct dirent* e;
+    while ((e = readdir(d)) != NULL && n < 256) {
+        char* dot = strrchr(e->d_name, '.');
+        if (dot && strcmp(dot, ".lvl") == 0) names[n++] = strdup(e->d_name);
+    }
+    closedir(d);
+
+    long bytes_per_round = 0;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < n; i++) {
+            board_t board;
+            memset(&board, 0, sizeof(board));
+            if (read_level(&board, names[i], dir) < 0) continue;
+            read_pacman(&board, 0);
+            read_ghosts(&board);
+
+            if (r == 0) {
+                bytes_per_round += file_size(dir, names[i]);
+                if (board.pacman_file[0]) bytes_per_round += file_size(NULL, board.pacman_file);
+                for (int g = 0; g < board.n_ghosts; g++) {
+                    bytes_per_round += file_size(NULL, board.ghosts_files[g]);
+                }
+            }
+
+            board_free_cells(&board);
+            free(board.pacmans);
+            free(board.ghosts);
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double secs = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    double mb = (double)bytes_per_round * rounds / (1024.0 * 1024.0);
+
+    printf("níveis: %d  rondas: %d  dados: %.1f MB  tempo: %.3f s  débito: %.1f MB/s\n",
+           n, rounds, mb, secs, secs > 0 ? mb / secs : 0.0);
+
+    for (int i = 0; i < n; i++) free(names[i]);
+    if (dir == gen_dir) remove_dir(gen_dir);
+    return 0;
+}
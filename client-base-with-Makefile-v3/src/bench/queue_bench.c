@@ -0,0 +1,169 @@
+// Benchmark da fila de pedidos de conexão: 1 produtor (como a thread
+// anfitriã) e N consumidores (como os workers) a passar pedidos pela fila
+// MPMC sem locks (request_buffer.c) e, para comparação, pela versão antiga
+// com dois semáforos e um mutex.
+//
+// Uso: queue_bench [consumidores] [pedidos] [capacidade]
+
+#include "request_buffer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
+
+#define DEFAULT_CONSUMERS 4
+#define DEFAULT_ITEMS 2000000
+#define DEFAULT_CAPACITY 16
+
+// ==================== FILA ANTIGA (SEMÁFOROS) ====================
+
+typedef struct {
+    connection_request_t* buffer;
+    int size;
+    int in;
+    int out;
+    pthread_mutex_t mutex;
+    sem_t empty;
+    sem_t full;
+} sem_buffer_t;
+
+static void sem_buffer_init(sem_buffer_t* buf, int size) {
+    buf->buffer = malloc(size * sizeof(connection_request_t));
+    buf->size = size;
+    buf->in = 0;
+    buf->out = 0;
+    pthread_mutex_init(&buf->mutex, NULL);
+    sem_init(&buf->empty, 0, size);
+    sem_init(&buf->full, 0, 0);
+}
+
+static void sem_buffer_destroy(sem_buffer_t* buf) {
+    free(buf->buffer);
+    pthread_mutex_destroy(&buf->mutex);
+    sem_destroy(&buf->empty);
+    sem_destroy(&buf->full);
+}
+
+static void sem_buffer_put(sem_buffer_t* buf, connection_request_t req) {
+    sem_wait(&buf->empty);
+    pthread_mutex_lock(&buf->mutex);
+    buf->buffer[buf->in] = req;
+    buf->in = (buf->in + 1) % buf->size;
+    pthread_mutex_unlock(&buf->mutex);
+    sem_post(&buf->full);
+}
+
+static connection_request_t sem_buffer_get(sem_buffer_t* buf) {
+    sem_wait(&buf->full);
+    pthread_mutex_lock(&buf->mutex);
+    connection_request_t req = buf->buffer[buf->out];
+    buf->out = (buf->out + 1) % buf->size;
+    pthread_mutex_unlock(&buf->mutex);
+    sem_post(&buf->empty);
+    return req;
+}
+
+// ==================== CORRIDA ====================
+
+typedef struct {
+    int lock_free;
+    request_buffer_t queue;
+    sem_buffer_t sem_queue;
+    long long sum[64];              // soma dos ids recebidos por consumidor
+} bench_t;
+
+typedef struct {
+    bench_t* bench;
+    int id;
+} consumer_arg_t;
+
+static void put(bench_t* b, connection_request_t req) {
+    if (b->lock_free) buffer_put(&b->queue, req);
+    else sem_buffer_put(&b->sem_queue, req);
+}
+
+static connection_request_t get(bench_t* b) {
+    return b->lock_free ? buffer_get(&b->queue) : sem_buffer_get(&b->sem_queue);
+}
+
+static void* consumer(void* arg) {
+    consumer_arg_t* c = arg;
+    long long sum = 0;
+    while (1) {
+        connection_request_t req = get(c->bench);
+        if (req.client_id < 0) break;   // sentinela: terminar
+        sum += req.client_id;
+    }
+    c->bench->sum[c->id] = sum;
+    return NULL;
+}
+
+static double run(bench_t* b, int consumers, int items) {
+    pthread_t tids[64];
+    consumer_arg_t args[64];
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (int i = 0; i < consumers; i++) {
+        args[i].bench = b;
+        args[i].id = i;
+        pthread_create(&tids[i], NULL, consumer, &args[i]);
+    }
+
+    connection_request_t req;
+    memset(&req, 0, sizeof(req));
+    for (int i = 0; i < items; i++) {
+        req.client_id = i;
+        put(b, req);
+    }
+    req.client_id = -1;
+    for (int i = 0; i < consumers; i++) put(b, req);
+
+    long long total = 0;
+    for (int i = 0; i < consumers; i++) {
+        pthread_join(tids[i], NULL);
+        total += b->sum[i];
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (total != (long long)items * (items - 1) / 2) {
+        fprintf(stderr, "ERRO: pedidos perdidos ou duplicados\n");
+    }
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+int main(int argc, char** argv) {
+    int consumers = argc > 1 ? atoi(argv[1]) : DEFAULT_CONSUMERS;
+    int items = argc > 2 ? atoi(argv[2]) : DEFAULT_ITEMS;
+    int capacity = argc > 3 ? atoi(argv[3]) : DEFAULT_CAPACITY;
+    if (consumers <= 0 || consumers > 64) consumers = DEFAULT_CONSUMERS;
+    if (items <= 0) items = DEFAULT_ITEMS;
+    if (capacity <= 0) capacity = DEFAULT_CAPACITY;
+
+    bench_t* b = calloc(1, sizeof(bench_t));
+    if (!b || buffer_init(&b->queue, capacity) < 0) {
+        fprintf(stderr, "Erro ao criar a fila\n");
+        return 1;
+    }
+    sem_buffer_init(&b->sem_queue, buffer_capacity(&b->queue));
+
+    printf("1 produtor, %d consumidores, %d pedidos, capacidade %d\n",
+           consumers, items, buffer_capacity(&b->queue));
+
+    b->lock_free = 0;
+    double secs = run(b, consumers, items);
+    printf("semáforos + mutex: %.3f s  (%.2f M pedidos/s)\n", secs, items / secs / 1e6);
+
+    b->lock_free = 1;
+    secs = run(b, consumers, items);
+    printf("MPMC sem locks:    %.3f s  (%.2f M pedidos/s)\n", secs, items / secs / 1e6);
+
+    buffer_destroy(&b->queue);
+    sem_buffer_destroy(&b->sem_queue);
+    free(b);
+    return 0;
+}
@@ -0,0 +1,209 @@
+// Benchmark da renderização no cliente: bytes enviados ao terminal por
+// frame por draw_board_client. Grava primeiro uma sessão jogando os níveis
+// de uma diretoria com o motor real (pacman ao calhas, fantasmas segundo os
+// ficheiros .m, a passar de nível e a recomeçar quando morre) e depois
+// reproduz as frames gravadas num ecrã ncurses cuja saída vai para um
+// ficheiro temporário: primeiro a redesenhar tudo em cada frame (como antes),
+// depois só as diferenças. O ecrã virtual é comparado com cada frame.
+//
+// Uso: render_bench [diretoria_níveis] [frames]
+
+#include "board.h"
+#include "display.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#define DEFAULT_LEVELS "levels"
+#define DEFAULT_FRAMES 2000
+#define BOARD_ROW 3     // primeira linha do tabuleiro (ver draw_board_client)
+
+// ==================== GRAVAÇÃO ====================
+
+static int record_frame(Board* frames, int n, board_t* board) {
+    int cells = board->width * board->height;
+    Board* frame = &frames[n];
+    frame->data = malloc(cells + 1);
+    if (!frame->data) return -1;
+    memcpy(frame->data, board->display, cells);
+    frame->data[cells] = '\0';
+
+    frame->width = board->width;
+    frame->height = board->height;
+    frame->tempo = board->tempo;
+    frame->accumulated_points = board->pacmans[0].points;
+    frame->game_over = !board->pacmans[0].alive;
+    frame->victory = board->portal_reached || (board->n_dots > 0 && board->dots_left == 0);
+    return 0;
+}
+
+// Um tick como o do servidor: pacman primeiro, depois os fantasmas
+static void play_tick(board_t* board) {
+    static const char moves[] = "WASD";
+    command_t cmd;
+    cmd.command = moves[rand() % 4];
+    cmd.turns = 1;
+    cmd.turns_left = 1;
+    move_pacman(board, 0, &cmd);
+
+    for (int g = 0; g < board->n_ghosts && board->pacmans[0].alive; g++) {
+        ghost_t* ghost = &board->ghosts[g];
+        if (ghost->n_moves == 0) continue;
+        cmd.command = ghost->moves[ghost->current_move % ghost->n_moves].command;
+        move_ghost(board, g, &cmd);
+    }
+}
+
+// Grava n frames; devolve quantas gravou
+static int record_session(char* dir, Board* frames, int n) {
+    int recorded = 0, level = 1, points = 0;
+
+    while (recorded < n) {
+        char name[32];
+        snprintf(name, sizeof(name), "%d.lvl", level);
+        board_t board;
+        memset(&board, 0, sizeof(board));
+        if (load_level(&board, name, dir, points) < 0) {
+            if (level == 1) break;  // a diretoria não tem níveis
+            level = 1;              // fim do jogo: volta ao primeiro
+            continue;
+        }
+
+        if (record_frame(frames, recorded++, &board) < 0) break;
+        while (recorded < n) {
+            play_tick(&board);
+            if (record_frame(frames, recorded, &board) < 0) break;
+            Board* frame = &frames[recorded++];
+            if (frame->victory) {
+                points = frame->accumulated_points;
+                level++;
+                break;
+            }
+            if (frame->game_over) {
+                points = 0;
+                level = 1;
+                break;
+            }
+        }
+        unload_level(&board);
+    }
+    return recorded;
+}
+
+// ==================== REPRODUÇÃO ====================
+
+static double elapsed_ns(const struct timespec* a, const struct timespec* b) {
+    return (b->tv_sec - a->tv_sec) * 1e9 + (b->tv_nsec - a->tv_nsec);
+}
+
+static long output_bytes(FILE* out) {
+    fflush(out);
+    return (long)lseek(fileno(out), 0, SEEK_CUR);
+}
+
+// O ecrã virtual tem de mostrar exatamente a frame (células e pontos)
+static int screen_matches(const Board* frame) {
+    for (int y = 0; y < frame->height; y++) {
+        for (int x = 0; x < frame->width; x++) {
+            char expected = frame->data[y * frame->width + x];
+            if (expected == 'G') expected = 'M';
+            if ((char)(mvinch(BOARD_ROW + y, x) & A_CHARTEXT) != expected) return 0;
+        }
+    }
+
+    char line[64], expected[64];
+    snprintf(expected, sizeof(expected), "Points: %d", frame->accumulated_points);
+    mvinnstr(BOARD_ROW + frame->height + 1, 0, line, (int)strlen(expected));
+    return strcmp(line, expected) == 0;
+}
+
+typedef struct {
+    long bytes;
+    long max_bytes;
+    double ns;
+    int mismatches;
+} replay_stats_t;
+
+static replay_stats_t replay(const Board* frames, int n, int full, FILE* out) {
+    replay_stats_t stats = {0, 0, 0, 0};
+    struct timespec t0, t1;
+
+    // Começar sempre de um ecrã limpo
+    draw_board_client_invalidate();
+    long before = output_bytes(out);
+
+    for (int i = 0; i < n; i++) {
+        if (full) draw_board_client_invalidate();
+
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        draw_board_client(frames[i]);
+        refresh_screen();
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        stats.ns += elapsed_ns(&t0, &t1);
+
+        long now = output_bytes(out);
+        if (now - before > stats.max_bytes) stats.max_bytes = now - before;
+        stats.bytes += now - before;
+        before = now;
+
+        if (!screen_matches(&frames[i])) stats.mismatches++;
+    }
+    return stats;
+}
+
+int main(int argc, char** argv) {
+    char* dir = argc > 1 ? argv[1] : DEFAULT_LEVELS;
+    int n = argc > 2 ? atoi(argv[2]) : DEFAULT_FRAMES;
+    if (n <= 0) n = DEFAULT_FRAMES;
+
+    Board* frames = calloc(n, sizeof(Board));
+    if (!frames) return 1;
+    srand(1);
+    int recorded = record_session(dir, frames, n);
+    if (recorded == 0) {
+        fprintf(stderr, "Nenhum nível em %s\n", dir);
+        free(frames);
+        return 1;
+    }
+
+    // O ecrã tem de caber no maior tabuleiro gravado
+    int rows = 0, cols = 80;
+    for (int i = 0; i < recorded; i++) {
+        if (frames[i].height + BOARD_ROW + 2 > rows) rows = frames[i].height + BOARD_ROW + 2;
+        if (frames[i].width > cols) cols = frames[i].width;
+    }
+    char value[16];
+    snprintf(value, sizeof(value), "%d", rows > 24 ? rows : 24);
+    setenv("LINES", value, 1);
+    snprintf(value, sizeof(value), "%d", cols);
+    setenv("COLUMNS", value, 1);
+
+    const char* term = getenv("TERM") ? getenv("TERM") : "xterm";
+    FILE* out = tmpfile();
+    FILE* in = fopen("/dev/null", "r");
+    if (!out || !in || terminal_init_file(out, in, term) < 0) {
+        fprintf(stderr, "Erro ao iniciar o ncurses (TERM=%s)\n", term);
+        return 1;
+    }
+
+    replay_stats_t full = replay(frames, recorded, 1, out);
+    replay_stats_t diff = replay(frames, recorded, 0, out);
+    terminal_cleanup();
+
+    printf("sessão gravada: %d frames (%s), TERM=%s\n", recorded, dir, term);
+    printf("redesenho completo: %7.1f bytes/frame (máx %ld)  %7.1f µs/frame\n",
+           (double)full.bytes / recorded, full.max_bytes, full.ns / recorded / 1e3);
+    printf("só diferenças:      %7.1f bytes/frame (máx %ld)  %7.1f µs/frame  (%.1fx menos bytes)\n",
+           (double)diff.bytes / recorded, diff.max_bytes, diff.ns / recorded / 1e3,
+           diff.bytes > 0 ? (double)full.bytes / diff.bytes : 0.0);
+    printf("frames diferentes do ecrã: %d (completo) / %d (diferenças)\n",
+           full.mismatches, diff.mismatches);
+
+    for (int i = 0; i < recorded; i++) free(frames[i].data);
+    free(frames);
+    fclose(in);
+    fclose(out);
+    return full.mismatches + diff.mismatches != 0;
+}
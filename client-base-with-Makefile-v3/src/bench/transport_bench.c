@@ -0,0 +1,293 @@
+// Benchmark dos transportes de ligação: latência de ligação e débito de
+// tabuleiros pelos FIFOs (pacman_connect) e pelo socket Unix SOCK_SEQPACKET
+// (pacman_connect_unix). O lado do cliente é o código real (api.c); o
+// servidor é uma thread mínima que fala o mesmo protocolo que o Pacmanist.
+// O débito é medido com receive_board_update (um tabuleiro alocado por
+// frame) e com receive_board_into (buffer reaproveitado).
+//
+// Uso: transport_bench [ligações] [frames] [largura] [altura]
+
+#include "api.h"
+#include "protocol.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define DEFAULT_CONNECTIONS 500
+#define DEFAULT_FRAMES 20000
+#define DEFAULT_WIDTH 32
+#define DEFAULT_HEIGHT 32
+
+// ==================== SERVIDOR MÍNIMO ====================
+
+typedef struct {
+    int use_socket;
+    int connections;        // ligações a aceitar
+    int frames;             // tabuleiros a enviar em cada ligação
+    int width;
+    int height;
+    char reg_path[MAX_PIPE_PATH_LENGTH];
+    int listen_fd;          // socket de escuta ou FIFO de registo
+} bench_server_t;
+
+// Aceita uma ligação pelo FIFO de registo (como a thread anfitriã + worker)
+static int accept_fifo(bench_server_t* srv, int* req_fd, int* notif_fd) {
+    char op_code;
+    char req_path[MAX_PIPE_PATH_LENGTH], notif_path[MAX_PIPE_PATH_LENGTH];
+    if (read(srv->listen_fd, &op_code, 1) != 1 ||
+        read(srv->listen_fd, req_path, sizeof(req_path)) != sizeof(req_path) ||
+        read(srv->listen_fd, notif_path, sizeof(notif_path)) != sizeof(notif_path)) {
+        return -1;
+    }
+    req_path[MAX_PIPE_PATH_LENGTH - 1] = notif_path[MAX_PIPE_PATH_LENGTH - 1] = '\0';
+
+    *req_fd = open(req_path, O_RDONLY | O_NONBLOCK);
+    *notif_fd = open(notif_path, O_WRONLY);
+    char response[2] = {OP_CODE_CONNECT, 0};
+    return write(*notif_fd, response, sizeof(response)) == sizeof(response) ? 0 : -1;
+}
+
+// Aceita uma ligação pelo socket (canais recebidos em SCM_RIGHTS)
+static int accept_socket(bench_server_t* srv, int* req_fd, int* notif_fd) {
+    int conn = accept(srv->listen_fd, NULL, NULL);
+    if (conn == -1) return -1;
+
+    char msg[SOCKET_CONNECT_SIZE];
+    struct iovec iov = {msg, sizeof(msg)};
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(2 * sizeof(int))];
+    } control;
+    struct msghdr mh;
+    memset(&mh, 0, sizeof(mh));
+    mh.msg_iov = &iov;
+    mh.msg_iovlen = 1;
+    mh.msg_control = control.buf;
+    mh.msg_controllen = sizeof(control.buf);
+
+    ssize_t n = recvmsg(conn, &mh, 0);
+    close(conn);
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&mh);
+    if (n != SOCKET_CONNECT_SIZE || !cmsg || cmsg->cmsg_type != SCM_RIGHTS) return -1;
+
+    int fds[2];
+    memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+    *req_fd = fds[0];
+    *notif_fd = fds[1];
+
+    char response[3 + SHM_NAME_FIELD_LENGTH] = {OP_CODE_CONNECT, 0, TRANSPORT_PIPE};
+    return write(*notif_fd, response, sizeof(response)) == sizeof(response) ? 0 : -1;
+}
+
+// Envia tabuleiros completos (um write por frame, como o servidor)
+static void stream_frames(bench_server_t* srv, int notif_fd) {
+    int cells = srv->width * srv->height;
+    int frame_len = 1 + 6 * (int)sizeof(int) + cells;
+    char* frame = malloc(frame_len);
+    int header[6] = {srv->width, srv->height, 100, 0, 0, 0};
+
+    frame[0] = OP_CODE_BOARD;
+    memset(frame + 1 + sizeof(header), '.', cells);
+    for (int i = 0; i < srv->frames; i++) {
+        header[5] = i;  // pontos: permite ao cliente validar a ordem
+        memcpy(frame + 1, header, sizeof(header));
+        if (write(notif_fd, frame, frame_len) != frame_len) break;
+    }
+    free(frame);
+}
+
+// Espera pelo pedido de desconexão do cliente (o FIFO de pedidos só tem
+// escritor depois de o cliente o abrir, já com a resposta recebida)
+static void await_disconnect(int req_fd) {
+    struct pollfd pfd = {req_fd, POLLIN, 0};
+    char op_code;
+    while (poll(&pfd, 1, -1) == -1 && errno == EINTR) {
+    }
+    while (read(req_fd, &op_code, 1) == -1 && errno == EINTR) {
+    }
+}
+
+static void* bench_server(void* arg) {
+    bench_server_t* srv = arg;
+
+    for (int c = 0; c < srv->connections; c++) {
+        int req_fd = -1, notif_fd = -1;
+        int ok = srv->use_socket ? accept_socket(srv, &req_fd, &notif_fd)
+                                 : accept_fifo(srv, &req_fd, &notif_fd);
+        if (ok < 0) {
+            fprintf(stderr, "ERRO: ligação %d falhou no servidor\n", c);
+            break;
+        }
+        if (srv->frames > 0) stream_frames(srv, notif_fd);
+
+        // Fechar antes de o cliente abrir o FIFO de pedidos deixava-o
+        // bloqueado no open
+        await_disconnect(req_fd);
+        close(req_fd);
+        close(notif_fd);
+    }
+    return NULL;
+}
+
+static int server_listen(bench_server_t* srv) {
+    if (srv->use_socket) {
+        srv->listen_fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", srv->reg_path);
+        unlink(srv->reg_path);
+        if (srv->listen_fd == -1 ||
+            bind(srv->listen_fd, (struct sockaddr*)&addr, sizeof(addr)) == -1 ||
+            listen(srv->listen_fd, 16) == -1) {
+            return -1;
+        }
+        return 0;
+    }
+
+    unlink(srv->reg_path);
+    if (mkfifo(srv->reg_path, 0666) == -1) return -1;
+    srv->listen_fd = open(srv->reg_path, O_RDWR);
+    return srv->listen_fd == -1 ? -1 : 0;
+}
+
+// ==================== CLIENTE ====================
+
+static double elapsed_s(const struct timespec* start) {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static int client_connect(bench_server_t* srv, int id) {
+    if (srv->use_socket) {
+        return pacman_connect_unix(srv->reg_path, id, TRANSPORT_PIPE);
+    }
+    char req[MAX_PIPE_PATH_LENGTH], notif[MAX_PIPE_PATH_LENGTH];
+    snprintf(req, sizeof(req), "/tmp/%d_tb%d_request", (int)getuid(), id);
+    snprintf(notif, sizeof(notif), "/tmp/%d_tb%d_notification", (int)getuid(), id);
+    return pacman_connect(req, notif, srv->reg_path);
+}
+
+// Devolve a latência média de ligação em µs (ou -1 em caso de erro)
+static double run_connect(bench_server_t* srv) {
+    pthread_t tid;
+    pthread_create(&tid, NULL, bench_server, srv);
+
+    double total = 0;
+    int done = 0;
+    for (int i = 0; i < srv->connections; i++) {
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        if (client_connect(srv, i) != 0) break;
+        total += elapsed_s(&start);
+        done++;
+        pacman_disconnect();
+    }
+
+    pthread_join(tid, NULL);
+    return done == srv->connections ? total / done * 1e6 : -1;
+}
+
+// Devolve o débito em frames/s (ou -1 em caso de erro)
+static double run_stream(bench_server_t* srv, int into) {
+    pthread_t tid;
+    pthread_create(&tid, NULL, bench_server, srv);
+
+    double rate = -1;
+    if (client_connect(srv, 0) == 0) {
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        int received = 0, out_of_order = 0;
+        Board reused = {0};
+        while (received < srv->frames) {
+            Board board = {0};
+            if (into) {
+                int result = receive_board_into(&reused, 0);
+                if (result == RECEIVE_CLOSED) break;
+                if (result == RECEIVE_BOARD) board = reused;
+            } else {
+                board = receive_board_update();
+                if (!board.data && board.game_over) break;
+            }
+            if (!board.data) {
+                sched_yield();
+                continue;
+            }
+            if (board.accumulated_points != received) out_of_order++;
+            received++;
+            if (!into) release_board(&board);
+        }
+        release_board(&reused);
+
+        double secs = elapsed_s(&start);
+        if (received == srv->frames && out_of_order == 0) rate = received / secs;
+        else fprintf(stderr, "ERRO: %d/%d frames, %d fora de ordem\n",
+                     received, srv->frames, out_of_order);
+        pacman_disconnect();
+    }
+
+    pthread_join(tid, NULL);
+    return rate;
+}
+
+int main(int argc, char** argv) {
+    int connections = argc > 1 ? atoi(argv[1]) : DEFAULT_CONNECTIONS;
+    int frames = argc > 2 ? atoi(argv[2]) : DEFAULT_FRAMES;
+    int width = argc > 3 ? atoi(argv[3]) : DEFAULT_WIDTH;
+    int height = argc > 4 ? atoi(argv[4]) : DEFAULT_HEIGHT;
+    if (connections <= 0) connections = DEFAULT_CONNECTIONS;
+    if (frames <= 0) frames = DEFAULT_FRAMES;
+    if (width <= 0 || height <= 0) {
+        width = DEFAULT_WIDTH;
+        height = DEFAULT_HEIGHT;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    int frame_bytes = 1 + 6 * (int)sizeof(int) + width * height;
+    printf("%d ligações; %d frames de %dx%d (%d bytes)\n",
+           connections, frames, width, height, frame_bytes);
+
+    const char* names[2] = {"FIFO", "SOCK_SEQPACKET"};
+    for (int use_socket = 0; use_socket <= 1; use_socket++) {
+        bench_server_t srv;
+        memset(&srv, 0, sizeof(srv));
+        srv.use_socket = use_socket;
+        srv.width = width;
+        srv.height = height;
+        snprintf(srv.reg_path, sizeof(srv.reg_path), "/tmp/%d_tb_%s", (int)getuid(),
+                 use_socket ? "sock" : "fifo");
+        if (server_listen(&srv) < 0) {
+            perror("Erro ao preparar o servidor do benchmark");
+            return 1;
+        }
+
+        srv.connections = connections;
+        srv.frames = 0;
+        double connect_us = run_connect(&srv);
+
+        srv.connections = 1;
+        srv.frames = frames;
+        double rate = run_stream(&srv, 0);
+        double rate_into = run_stream(&srv, 1);
+
+        printf("%-15s ligação: %8.1f µs   débito: %9.0f frames/s (%.1f MB/s)   into: %9.0f frames/s\n",
+               names[use_socket], connect_us, rate, rate * frame_bytes / 1e6, rate_into);
+
+        close(srv.listen_fd);
+        unlink(srv.reg_path);
+    }
+    return 0;
+}
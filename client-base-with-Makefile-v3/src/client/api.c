@@ -1,5 +1,6 @@
 #include "api.h"
 #include "protocol.h"
+#include "shm_ring.h"
 #include "debug.h"
 #include <errno.h>
 #include <fcntl.h>
@@ -8,6 +9,19 @@
 #include <stdio.h>
 #include <sys/stat.h>
 #include <stdlib.h>
+#include <poll.h>
+#include <time.h>
+#include <stdatomic.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// Estado de uma sessão num canal multiplexado
+enum {
+    MUX_CONNECTING = 0,     // à espera da resposta a OP_CODE_CONNECT
+    MUX_OPEN = 1,
+    MUX_CLOSING = 2,        // o cliente desligou: falta o fim vindo do servidor
+    MUX_CLOSED = 3,         // o servidor terminou a sessão
+};
 
 // Estrutura da sessão (como no código base)
 struct Session {
@@ -16,23 +30,264 @@ struct Session {
     int notif_pipe;
     char req_pipe_path[MAX_PIPE_PATH_LENGTH + 1];
     char notif_pipe_path[MAX_PIPE_PATH_LENGTH + 1];
+    // Último tabuleiro completo conhecido (base para aplicar os deltas)
+    char* grid;
+    int width;
+    int height;
+    int tempo;
+    // TRANSPORT_SHM: anel de frames partilhado com o servidor
+    int transport;
+    shm_ring_t* ring;
+    size_t ring_size;
+    // Ligação por socket: os canais são SOCK_SEQPACKET (um datagrama por
+    // mensagem), recebidos inteiros para packet
+    int seqpacket;
+    char* packet;
+    size_t packet_cap;
+    // Sessão dentro de um canal multiplexado (os canais são os do mux)
+    struct pacman_mux* mux;
+    int mux_state;
+    // FIFO: bytes lidos ainda por interpretar (uma frame pode chegar aos
+    // bocados; só se entrega quando está completa)
+    char* rbuf;
+    size_t rcap;
+    size_t rlen;
+    size_t roff;
+    // Espera bloqueante: wake_fds[0] entra no poll e receive_board_cancel
+    // escreve em wake_fds[1]
+    int wake_fds[2];
+    _Atomic int cancelled;
 };
 
-static struct Session session = {.id = -1, .req_pipe = -1, .notif_pipe = -1};
+// Datagrama guardado enquanto se esperava pela resposta de outra sessão
+typedef struct mux_pending {
+    struct mux_pending* next;
+    ssize_t len;
+    char data[];
+} mux_pending_t;
 
-int pacman_connect(char const *req_pipe_path, char const *notif_pipe_path, char const *server_pipe_path) {
+// Canal multiplexado: um par de canais SOCK_SEQPACKET partilhado por todas
+// as sessões abertas nele
+struct pacman_mux {
+    int req_fd;
+    int notif_fd;
+    struct Session** sessions;      // session_id -> sessão (NULL: livre)
+    char* packet;
+    size_t packet_cap;
+    mux_pending_t* pending_head;
+    mux_pending_t* pending_tail;
+};
+
+// Tempo máximo que receive_board_update espera pela campainha do anel
+#define SHM_RECEIVE_WAIT_MS 10
+
+// Com o anel, a espera é no futex: um cancelamento que chegue mesmo antes de
+// dormir só é visto ao fim desta fatia
+#define SHM_CANCEL_CHECK_MS 50
+
+// Leitura mínima do FIFO de notificações de cada vez
+#define STREAM_READ_CHUNK 4096
+
+// Maior tabuleiro aceite (defesa contra cabeçalhos corrompidos)
+#define STREAM_MAX_CELLS (1 << 24)
+
+static struct Session session = {.id = -1, .req_pipe = -1, .notif_pipe = -1, .wake_fds = {-1, -1}};
+
+static void session_init(struct Session* s) {
+    memset(s, 0, sizeof(struct Session));
+    s->id = -1;
+    s->req_pipe = -1;
+    s->notif_pipe = -1;
+    s->transport = TRANSPORT_PIPE;
+    s->wake_fds[0] = s->wake_fds[1] = -1;
+}
+
+// Canal para acordar uma espera em receive (criado com a ligação)
+static int session_open_wake(struct Session* s) {
+    if (pipe(s->wake_fds) == -1) {
+        debug("Erro ao criar pipe de cancelamento\n");
+        s->wake_fds[0] = s->wake_fds[1] = -1;
+        return -1;
+    }
+    for (int i = 0; i < 2; i++) {
+        int flags = fcntl(s->wake_fds[i], F_GETFL);
+        fcntl(s->wake_fds[i], F_SETFL, flags | O_NONBLOCK);
+    }
+    atomic_store(&s->cancelled, 0);
+    return 0;
+}
+
+// Guarda o tabuleiro recebido como base para os próximos deltas
+static int cache_grid(struct Session* s, int width, int height, int tempo, const char* data) {
+    int size = width * height;
+    if (width != s->width || height != s->height || !s->grid) {
+        free(s->grid);
+        s->grid = malloc(size);
+        if (!s->grid) {
+            s->width = s->height = 0;
+            return -1;
+        }
+        s->width = width;
+        s->height = height;
+    }
+    s->tempo = tempo;
+    memcpy(s->grid, data, size);
+    return 0;
+}
+
+// Aplica n entradas { index | cell } de um delta ao tabuleiro em cache
+static void apply_delta_entries(struct Session* s, const char* entries, int n) {
+    int size = s->width * s->height;
+    for (int i = 0; i < n; i++) {
+        int index;
+        memcpy(&index, entries + i * DELTA_ENTRY_SIZE, sizeof(int));
+        if (index >= 0 && index < size) {
+            s->grid[index] = entries[i * DELTA_ENTRY_SIZE + sizeof(int)];
+        }
+    }
+}
+
+// ==================== LIGAÇÃO ====================
+
+// Aplica o transporte de uma resposta no formato de OP_CODE_CONNECT_EX
+// (mapeia o anel partilhado se o servidor o escolheu)
+static int use_transport(struct Session* s, const char* response) {
+    s->transport = TRANSPORT_PIPE;
+    if (response[2] != TRANSPORT_SHM) return 0;
+
+    char shm_name[SHM_NAME_FIELD_LENGTH + 1] = {0};
+    memcpy(shm_name, response + 3, SHM_NAME_FIELD_LENGTH);
+    s->ring = shm_ring_attach(shm_name, &s->ring_size);
+    if (!s->ring) {
+        debug("Erro ao mapear memória partilhada: %s\n", shm_name);
+        return -1;
+    }
+    s->transport = TRANSPORT_SHM;
+    return 0;
+}
+
+// Junta os dois canais (pontas do servidor) a um datagrama com SCM_RIGHTS
+static ssize_t send_with_fds(int sock, const char* msg, size_t len, const int fds[2]) {
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(2 * sizeof(int))];
+    } control;
+    memset(&control, 0, sizeof(control));
+
+    struct iovec iov = {(void*)msg, len};
+    struct msghdr mh;
+    memset(&mh, 0, sizeof(mh));
+    mh.msg_iov = &iov;
+    mh.msg_iovlen = 1;
+    mh.msg_control = control.buf;
+    mh.msg_controllen = sizeof(control.buf);
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&mh);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(2 * sizeof(int));
+    memcpy(CMSG_DATA(cmsg), fds, 2 * sizeof(int));
+
+    return sendmsg(sock, &mh, 0);
+}
+
+// Pedido de ligação pelo socket do servidor. Devolve 0 com os canais do
+// cliente em fds (o de notificações já não bloqueante) e a resposta em
+// response, ou -1.
+static int socket_handshake(char const* socket_path, int client_id, int transport, int fds[2],
+                            char response[3 + SHM_NAME_FIELD_LENGTH]) {
+    // Um socketpair por canal, em vez dos dois FIFOs: as pontas [1] vão para
+    // o servidor dentro do pedido de ligação
+    int req_pair[2], notif_pair[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, req_pair) == -1) {
+        debug("Erro ao criar canal de pedidos\n");
+        return -1;
+    }
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, notif_pair) == -1) {
+        debug("Erro ao criar canal de notificações\n");
+        close(req_pair[0]);
+        close(req_pair[1]);
+        return -1;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", socket_path);
+
+    char msg[SOCKET_CONNECT_SIZE];
+    msg[0] = OP_CODE_CONNECT;
+    msg[1] = (char)transport;
+    memcpy(msg + 2, &client_id, sizeof(int));
+    int server_ends[2] = {req_pair[1], notif_pair[1]};
+
+    int server_fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    int sent = server_fd != -1 &&
+               connect(server_fd, (struct sockaddr*)&addr, sizeof(addr)) == 0 &&
+               send_with_fds(server_fd, msg, sizeof(msg), server_ends) == (ssize_t)sizeof(msg);
+
+    // O servidor tem agora as suas próprias cópias das pontas
+    if (server_fd != -1) close(server_fd);
+    close(req_pair[1]);
+    close(notif_pair[1]);
+
+    // Aguardar resposta (pelo canal de notificações, ainda bloqueante)
+    if (!sent ||
+        recv(notif_pair[0], response, 3 + SHM_NAME_FIELD_LENGTH, 0) != 3 + SHM_NAME_FIELD_LENGTH ||
+        response[0] != OP_CODE_CONNECT || response[1] != 0) {
+        debug("Erro ao ligar pelo socket %s\n", socket_path);
+        close(req_pair[0]);
+        close(notif_pair[0]);
+        return -1;
+    }
+
+    int flags = fcntl(notif_pair[0], F_GETFL);
+    fcntl(notif_pair[0], F_SETFL, flags | O_NONBLOCK);
+
+    fds[0] = req_pair[0];
+    fds[1] = notif_pair[0];
+    return 0;
+}
+
+static int session_connect_unix(struct Session* s, char const* socket_path, int client_id,
+                                int transport) {
+    int fds[2];
+    char response[3 + SHM_NAME_FIELD_LENGTH];
+    if (socket_handshake(socket_path, client_id, transport, fds, response) < 0) {
+        return 1;
+    }
+    if (use_transport(s, response) < 0 || session_open_wake(s) < 0) {
+        shm_ring_unmap(s->ring, s->ring_size);
+        s->ring = NULL;
+        close(fds[0]);
+        close(fds[1]);
+        return 1;
+    }
+
+    s->req_pipe = fds[0];
+    s->notif_pipe = fds[1];
+    s->seqpacket = 1;
+    s->req_pipe_path[0] = '\0';
+    s->notif_pipe_path[0] = '\0';
+
+    debug("Conexão estabelecida com sucesso (socket)\n");
+    return 0;
+}
+
+static int session_connect(struct Session* s, char const *req_pipe_path, char const *notif_pipe_path,
+                           char const *server_pipe_path, int transport) {
     // Criar pipes
     if (mkfifo(req_pipe_path, 0666) == -1 && errno != EEXIST) {
         debug("Erro ao criar pipe de pedidos: %s\n", req_pipe_path);
         return 1;
     }
-    
+
     if (mkfifo(notif_pipe_path, 0666) == -1 && errno != EEXIST) {
         debug("Erro ao criar pipe de notificações: %s\n", notif_pipe_path);
         unlink(req_pipe_path);
         return 1;
     }
-    
+
     // Abrir pipe do servidor
     int server_fd = open(server_pipe_path, O_WRONLY | O_NONBLOCK);
     if (server_fd == -1) {
@@ -41,28 +296,31 @@ int pacman_connect(char const *req_pipe_path, char const *notif_pipe_path, char
         unlink(notif_pipe_path);
         return 1;
     }
-    
-    // Enviar pedido de conexão (formato OP_CODE=1 + 2 pipes)
-    char op_code = OP_CODE_CONNECT; // 1
 
-    // Strings de tamanho fixo 40 bytes, preenchidas com '\0'
-    char req_buf[MAX_PIPE_PATH_LENGTH] = {0};
-    char notif_buf[MAX_PIPE_PATH_LENGTH] = {0};
-    strncpy(req_buf, req_pipe_path, MAX_PIPE_PATH_LENGTH - 1);
-    strncpy(notif_buf, notif_pipe_path, MAX_PIPE_PATH_LENGTH - 1);
+    // Enviar pedido de conexão (formato OP_CODE=1 + 2 pipes; com outro
+    // transporte, OP_CODE=7 + 2 pipes + transporte)
+    char op_code = transport == TRANSPORT_PIPE ? OP_CODE_CONNECT : OP_CODE_CONNECT_EX;
+
+    // Strings de tamanho fixo 40 bytes, preenchidas com '\0'. O pedido vai
+    // num só write (menos de PIPE_BUF, logo atómico): vários clientes a
+    // ligar ao mesmo tempo não intercalam os bytes no FIFO de registo
+    char request[2 + 2 * MAX_PIPE_PATH_LENGTH] = {0};
+    ssize_t request_len = 1 + 2 * MAX_PIPE_PATH_LENGTH;
+    request[0] = op_code;
+    strncpy(request + 1, req_pipe_path, MAX_PIPE_PATH_LENGTH - 1);
+    strncpy(request + 1 + MAX_PIPE_PATH_LENGTH, notif_pipe_path, MAX_PIPE_PATH_LENGTH - 1);
+    if (op_code == OP_CODE_CONNECT_EX) request[request_len++] = (char)transport;
 
-    if (write(server_fd, &op_code, 1) != 1 ||
-        write(server_fd, req_buf, MAX_PIPE_PATH_LENGTH) != MAX_PIPE_PATH_LENGTH ||
-        write(server_fd, notif_buf, MAX_PIPE_PATH_LENGTH) != MAX_PIPE_PATH_LENGTH) {
+    if (write(server_fd, request, request_len) != request_len) {
         debug("Erro ao enviar pedido de conexão\n");
         close(server_fd);
         unlink(req_pipe_path);
         unlink(notif_pipe_path);
         return 1;
     }
-    
+
     close(server_fd);
-    
+
     // Aguardar resposta (pelo pipe de notificações)
     int notif_fd = open(notif_pipe_path, O_RDONLY);
     if (notif_fd == -1) {
@@ -71,160 +329,882 @@ int pacman_connect(char const *req_pipe_path, char const *notif_pipe_path, char
         unlink(notif_pipe_path);
         return 1;
     }
-    
-    char response[2];
-    if (read(notif_fd, response, 2) != 2) {
+
+    char response[3 + SHM_NAME_FIELD_LENGTH];
+    ssize_t response_len = op_code == OP_CODE_CONNECT_EX ? (ssize_t)sizeof(response) : 2;
+    if (read(notif_fd, response, response_len) != response_len) {
         debug("Erro ao ler resposta do servidor\n");
         close(notif_fd);
         unlink(req_pipe_path);
         unlink(notif_pipe_path);
         return 1;
     }
-    
-    close(notif_fd);
-    
+
     // Verificar resposta (OP_CODE=1, result=0)
     if (response[0] != OP_CODE_CONNECT || response[1] != 0) {
         debug("Conexão rejeitada pelo servidor\n");
+        close(notif_fd);
+        unlink(req_pipe_path);
+        unlink(notif_pipe_path);
+        return 1;
+    }
+
+    // O servidor escolheu a memória partilhada: mapear o anel já
+    s->transport = TRANSPORT_PIPE;
+    if (op_code == OP_CODE_CONNECT_EX && use_transport(s, response) < 0) {
+        close(notif_fd);
         unlink(req_pipe_path);
         unlink(notif_pipe_path);
         return 1;
     }
-    
+
     // Abrir pipes para comunicação futura
-    session.req_pipe = open(req_pipe_path, O_WRONLY);
-    if (session.req_pipe == -1) {
+    s->req_pipe = open(req_pipe_path, O_WRONLY);
+    if (s->req_pipe == -1) {
         debug("Erro ao abrir pipe de pedidos para escrita\n");
+        close(notif_fd);
+        shm_ring_unmap(s->ring, s->ring_size);
+        s->ring = NULL;
         unlink(req_pipe_path);
         unlink(notif_pipe_path);
         return 1;
     }
-    
-    session.notif_pipe = open(notif_pipe_path, O_RDONLY | O_NONBLOCK);
-    if (session.notif_pipe == -1) {
+
+    // O FIFO de notificações continua aberto desde a resposta: fechá-lo e
+    // voltar a abrir deixava um intervalo sem leitor em que as primeiras
+    // frames do servidor falhavam com EPIPE
+    s->notif_pipe = notif_fd;
+    int flags = fcntl(notif_fd, F_GETFL);
+    if (fcntl(notif_fd, F_SETFL, flags | O_NONBLOCK) == -1 || session_open_wake(s) < 0) {
         debug("Erro ao abrir pipe de notificações para leitura\n");
-        close(session.req_pipe);
+        if (s->notif_pipe != -1) close(s->notif_pipe);
+        s->notif_pipe = -1;
+        close(s->req_pipe);
+        s->req_pipe = -1;
+        shm_ring_unmap(s->ring, s->ring_size);
+        s->ring = NULL;
         unlink(req_pipe_path);
         unlink(notif_pipe_path);
         return 1;
     }
-    
+
     // Guardar paths (para desconexão)
-    strncpy(session.req_pipe_path, req_pipe_path, MAX_PIPE_PATH_LENGTH);
-    strncpy(session.notif_pipe_path, notif_pipe_path, MAX_PIPE_PATH_LENGTH);
-    
+    strncpy(s->req_pipe_path, req_pipe_path, MAX_PIPE_PATH_LENGTH);
+    strncpy(s->notif_pipe_path, notif_pipe_path, MAX_PIPE_PATH_LENGTH);
+
     debug("Conexão estabelecida com sucesso\n");
     return 0;
 }
 
-void pacman_play(char command) {
-    if (session.req_pipe == -1) {
+// ==================== PEDIDOS ====================
+
+// Envia uma mensagem pelo canal de pedidos (num canal multiplexado, com o
+// prefixo da sessão, no mesmo datagrama)
+static int session_send(struct Session* s, const char* msg, int len) {
+    if (!s->mux) {
+        return write(s->req_pipe, msg, len) == len ? 0 : -1;
+    }
+
+    char packet[MUX_HEADER_SIZE + PLAY_BATCH_HEADER_SIZE + MAX_PLAY_BATCH * PLAY_BATCH_ENTRY_SIZE];
+    if (len > (int)sizeof(packet) - MUX_HEADER_SIZE) return -1;
+    packet[0] = OP_CODE_MUX;
+    memcpy(packet + 1, &s->id, sizeof(int));
+    memcpy(packet + MUX_HEADER_SIZE, msg, len);
+    return send(s->mux->req_fd, packet, MUX_HEADER_SIZE + len, 0) == MUX_HEADER_SIZE + len ? 0 : -1;
+}
+
+static void session_play(struct Session* s, char command) {
+    if (s->req_pipe == -1 || (s->mux && s->mux_state != MUX_OPEN)) {
         debug("Tentativa de jogar sem conexão ativa\n");
         return;
     }
-    
+
     // Enviar comando (OP_CODE=3 + comando)
     char op_code = OP_CODE_PLAY; // 3
     char msg[2] = {op_code, command};
-    
-    if (write(session.req_pipe, msg, 2) != 2) {
+
+    if (session_send(s, msg, 2) < 0) {
         debug("Erro ao enviar comando\n");
     }
-    
+
     debug("Comando enviado: %c\n", command);
 }
 
-int pacman_disconnect() {
-    if (session.req_pipe == -1) {
+static int session_play_batch(struct Session* s, play_cmd_t const* cmds, int n) {
+    if (s->req_pipe == -1 || (s->mux && s->mux_state != MUX_OPEN)) {
+        debug("Tentativa de jogar sem conexão ativa\n");
+        return 1;
+    }
+
+    // Uma mensagem (um write) por cada MAX_PLAY_BATCH comandos
+    char msg[PLAY_BATCH_HEADER_SIZE + MAX_PLAY_BATCH * PLAY_BATCH_ENTRY_SIZE];
+    for (int sent = 0; sent < n; ) {
+        int count = n - sent < MAX_PLAY_BATCH ? n - sent : MAX_PLAY_BATCH;
+
+        char* p = msg;
+        *p++ = OP_CODE_PLAY_BATCH;
+        memcpy(p, &count, sizeof(int));
+        p += sizeof(int);
+        for (int i = 0; i < count; i++) {
+            *p++ = cmds[sent + i].command;
+            memcpy(p, &cmds[sent + i].repeat, sizeof(int));
+            p += sizeof(int);
+        }
+
+        if (session_send(s, msg, (int)(p - msg)) < 0) {
+            debug("Erro ao enviar lote de comandos\n");
+            return 1;
+        }
+        sent += count;
+    }
+
+    debug("Lote de %d comandos enviado\n", n);
+    return 0;
+}
+
+// Fecha os canais próprios da sessão e volta ao estado inicial
+static int session_disconnect(struct Session* s) {
+    if (s->req_pipe == -1) {
         debug("Tentativa de desconectar sem conexão ativa\n");
         return 1;
     }
-    
+
     // Enviar pedido de desconexão (OP_CODE=2)
     char op_code = OP_CODE_DISCONNECT; // 2
-    
-    if (write(session.req_pipe, &op_code, 1) != 1) {
+
+    if (write(s->req_pipe, &op_code, 1) != 1) {
         debug("Erro ao enviar pedido de desconexão\n");
     }
-    
+
     // Fechar pipes (sem esperar por respostas)
-    close(session.req_pipe);
-    close(session.notif_pipe);
-    
-    // Remover pipes (apagar named pipes do cliente)
-    unlink(session.req_pipe_path);
-    unlink(session.notif_pipe_path);
-    
+    close(s->req_pipe);
+    close(s->notif_pipe);
+    close(s->wake_fds[0]);
+    close(s->wake_fds[1]);
+
+    // Remover pipes (apagar named pipes do cliente; não há com sockets)
+    if (!s->seqpacket) {
+        unlink(s->req_pipe_path);
+        unlink(s->notif_pipe_path);
+    }
+
     // Resetar sessão
-    session.req_pipe = -1;
-    session.notif_pipe = -1;
-    session.req_pipe_path[0] = '\0';
-    session.notif_pipe_path[0] = '\0';
-    
+    free(s->grid);
+    shm_ring_unmap(s->ring, s->ring_size);
+    free(s->packet);
+    free(s->rbuf);
+    session_init(s);
+
     debug("Desconectado com sucesso\n");
     return 0;
 }
 
-Board receive_board_update(void) {
+// ==================== TABULEIROS ====================
+
+// ==================== ESPERA ====================
+
+// Prazo absoluto para uma espera de timeout_ms (< 0: sem limite)
+static void wait_deadline(struct timespec* deadline, int timeout_ms) {
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    if (timeout_ms < 0) return;
+    deadline->tv_sec += timeout_ms / 1000;
+    deadline->tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (deadline->tv_nsec >= 1000000000L) {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+}
+
+// Milissegundos até ao prazo (-1 sem limite, 0 se já passou)
+static int wait_remaining_ms(const struct timespec* deadline, int timeout_ms) {
+    if (timeout_ms < 0) return -1;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long ms = (deadline->tv_sec - now.tv_sec) * 1000 + (deadline->tv_nsec - now.tv_nsec) / 1000000;
+    return ms > 0 ? (int)ms : 0;
+}
+
+// Consome um pedido de cancelamento pendente (devolve 1 se havia)
+static int take_cancel(struct Session* s) {
+    return atomic_exchange(&s->cancelled, 0);
+}
+
+// Bloqueia até o canal de notificações ter dados, o prazo acabar ou alguém
+// cancelar. Devolve 1 se há dados para ler, 0 caso contrário.
+static int wait_readable(struct Session* s, const struct timespec* deadline, int timeout_ms) {
+    while (1) {
+        int remaining = wait_remaining_ms(deadline, timeout_ms);
+        if (remaining == 0 || take_cancel(s)) return 0;
+
+        struct pollfd pfd[2] = {
+            {s->notif_pipe, POLLIN, 0},
+            {s->wake_fds[0], POLLIN, 0},
+        };
+        int n = poll(pfd, s->wake_fds[0] != -1 ? 2 : 1, remaining);
+        if (n < 0 && errno != EINTR) return 0;
+
+        // Os bytes do pipe de cancelamento só acordam: o pedido é a flag
+        if (n > 0 && s->wake_fds[0] != -1 && pfd[1].revents) {
+            char drain[16];
+            while (read(s->wake_fds[0], drain, sizeof(drain)) > 0) {
+            }
+        }
+        if (take_cancel(s)) return 0;
+        if (n > 0 && pfd[0].revents) return 1;
+    }
+}
+
+// Próxima frame do anel partilhado (NULL se não chegou nenhuma; *closed
+// fica a 1 se o servidor já fechou a sessão)
+static shm_frame_t* wait_shm_frame(struct Session* s, int timeout_ms, int* closed) {
+    struct timespec deadline;
+    wait_deadline(&deadline, timeout_ms);
+
+    // O futex do anel não entra num poll: esperar em fatias e olhar para o
+    // cancelamento entre elas (receive_board_cancel também acorda o futex)
+    shm_frame_t* frame = NULL;
+    *closed = 0;
+    while (1) {
+        int remaining = wait_remaining_ms(&deadline, timeout_ms);
+        int slice = remaining < 0 || remaining > SHM_CANCEL_CHECK_MS ? SHM_CANCEL_CHECK_MS : remaining;
+        if (timeout_ms == 0) slice = SHM_RECEIVE_WAIT_MS;
+
+        frame = shm_ring_next(s->ring, slice, closed);
+        if (frame || *closed || take_cancel(s) || timeout_ms == 0 ||
+            wait_remaining_ms(&deadline, timeout_ms) == 0) {
+            return frame;
+        }
+    }
+}
+
+// Próxima frame do anel partilhado: board.data aponta para a própria frame
+// (sem cópias) até ser devolvida com release_board
+static Board receive_board_shm(struct Session* s, int timeout_ms) {
     Board board = {0};
-    
-    if (session.notif_pipe == -1) {
+    int closed;
+    shm_frame_t* frame = wait_shm_frame(s, timeout_ms, &closed);
+
+    if (!frame) {
+        // Sem frames e o servidor já fechou a sessão -> fim de jogo
+        if (closed) board.game_over = 1;
         return board;
     }
-    
-    // Tentar ler atualização (pipe está em modo não-bloqueante)
-    char op_code;
-    ssize_t bytes = read(session.notif_pipe, &op_code, 1);
 
-    if (bytes < 0) {
-        // Sem dados disponíveis neste momento (EAGAIN/EWOULDBLOCK): apenas não há update
-        if (errno == EAGAIN || errno == EWOULDBLOCK) {
-            return board; // board.data == NULL sinaliza "sem atualização"
+    board.width = frame->width;
+    board.height = frame->height;
+    board.tempo = frame->tempo;
+    board.victory = frame->victory;
+    board.game_over = frame->game_over;
+    board.accumulated_points = frame->points;
+    board.data = frame->data;
+    return board;
+}
+
+static void session_release_board(struct Session* s, Board* board) {
+    if (!board->data) return;
+
+    char* ring_start = (char*)s->ring;
+    if (s->ring && board->data > ring_start && board->data < ring_start + s->ring_size) {
+        shm_ring_release(s->ring);
+    } else {
+        free(board->data);
+    }
+    board->data = NULL;
+}
+
+// Prepara board->data para width x height células (+ '\0'). Só realoca
+// quando o número de células muda: em regime normal não há alocações.
+static int board_reserve(Board* board, int width, int height) {
+    int cells = width * height;
+    if (!board->data || cells != board->width * board->height) {
+        char* data = realloc(board->data, cells + 1);
+        if (!data) {
+            debug("Erro de alocação de memória\n");
+            return -1;
         }
+        board->data = data;
+    }
+    board->width = width;
+    board->height = height;
+    return 0;
+}
 
-        // Erro real
-        return board;
+// Copia a próxima frame do anel para *board e devolve logo o slot ao servidor
+static int receive_board_shm_into(struct Session* s, Board* board, int timeout_ms) {
+    int closed;
+    shm_frame_t* frame = wait_shm_frame(s, timeout_ms, &closed);
+    if (!frame) return closed ? RECEIVE_CLOSED : RECEIVE_NONE;
+
+    int result = RECEIVE_NONE;
+    if (board_reserve(board, frame->width, frame->height) == 0) {
+        board->tempo = frame->tempo;
+        board->victory = frame->victory;
+        board->game_over = frame->game_over;
+        board->accumulated_points = frame->points;
+        memcpy(board->data, frame->data, frame->width * frame->height + 1);
+        result = RECEIVE_BOARD;
     }
+    shm_ring_release(s->ring);
+    return result;
+}
 
-    if (bytes == 0) {
-        // EOF: servidor fechou pipe -> sinalizar fim de jogo
-        board.game_over = 1;
-        return board;
+// Lê o próximo datagrama de um canal SOCK_SEQPACKET para *buf (aumentado se
+// preciso). Devolve o tamanho, 0 se o canal fechou ou -1 sem dados/erro.
+static ssize_t recv_packet(int fd, char** buf, size_t* cap) {
+    // Tamanho do próximo datagrama (MSG_TRUNC devolve o tamanho real)
+    ssize_t len = recv(fd, NULL, 0, MSG_PEEK | MSG_TRUNC);
+    if (len <= 0) return len;
+
+    if ((size_t)len > *cap) {
+        char* grown = realloc(*buf, len);
+        if (!grown) {
+            debug("Erro de alocação de memória\n");
+            return -1;
+        }
+        *buf = grown;
+        *cap = len;
     }
-    
-    if (op_code != OP_CODE_BOARD) { // 4
-        debug("Código de operação inválido: %d\n", op_code);
-        return board;
+    if (recv(fd, *buf, len, 0) != len) {
+        debug("Erro ao ler datagrama do socket\n");
+        return -1;
     }
-    
-    // Ler dados do tabuleiro
-    if (read(session.notif_pipe, &board.width, sizeof(int)) != sizeof(int) ||
-        read(session.notif_pipe, &board.height, sizeof(int)) != sizeof(int) ||
-        read(session.notif_pipe, &board.tempo, sizeof(int)) != sizeof(int) ||
-        read(session.notif_pipe, &board.victory, sizeof(int)) != sizeof(int) ||
-        read(session.notif_pipe, &board.game_over, sizeof(int)) != sizeof(int) ||
-        read(session.notif_pipe, &board.accumulated_points, sizeof(int)) != sizeof(int)) {
-        debug("Erro ao ler dados do tabuleiro\n");
-        return board;
+    return len;
+}
+
+// Interpreta uma mensagem completa (OP_CODE_BOARD ou OP_CODE_BOARD_DELTA)
+// para *board, reaproveitando board->data. Devolve 0, ou -1 se a mensagem
+// não é válida (*board fica como estava).
+static int parse_board_message(struct Session* s, const char* msg, ssize_t len, Board* board) {
+    const char* p = msg;
+    char op_code = *p++;
+    int header[6];
+
+    if (op_code == OP_CODE_BOARD_DELTA && len >= 1 + 4 * (ssize_t)sizeof(int)) {
+        int n_changes;
+        memcpy(header, p, 3 * sizeof(int));
+        memcpy(&n_changes, p + 3 * sizeof(int), sizeof(int));
+        p += 4 * sizeof(int);
+        if (!s->grid || n_changes < 0 ||
+            len != 1 + 4 * (ssize_t)sizeof(int) + (ssize_t)n_changes * DELTA_ENTRY_SIZE) {
+            debug("Delta sem tabuleiro base válido\n");
+            return -1;
+        }
+        apply_delta_entries(s, p, n_changes);
+        if (board_reserve(board, s->width, s->height) < 0) return -1;
+
+        board->tempo = s->tempo;
+        board->victory = header[0];
+        board->game_over = header[1];
+        board->accumulated_points = header[2];
+        p = s->grid;
+    } else if (op_code == OP_CODE_BOARD && len >= 1 + 6 * (ssize_t)sizeof(int)) {
+        memcpy(header, p, sizeof(header));
+        p += sizeof(header);
+        if (header[0] <= 0 || header[1] <= 0 ||
+            len != 1 + (ssize_t)sizeof(header) + (ssize_t)header[0] * header[1]) {
+            debug("Tabuleiro com tamanho inválido\n");
+            return -1;
+        }
+        if (cache_grid(s, header[0], header[1], header[2], p) < 0) {
+            debug("Erro de alocação de memória\n");
+        }
+        if (board_reserve(board, header[0], header[1]) < 0) return -1;
+
+        board->tempo = header[2];
+        board->victory = header[3];
+        board->game_over = header[4];
+        board->accumulated_points = header[5];
+    } else {
+        debug("Mensagem inválida no socket: %d\n", op_code);
+        return -1;
     }
-      
-    // Alocar e ler dados do tabuleiro
-    int board_size = board.width * board.height;
-    board.data = malloc(board_size + 1);
-    
-    if (!board.data) {
+
+    int board_size = board->width * board->height;
+    memcpy(board->data, p, board_size);
+    board->data[board_size] = '\0';
+    return 0;
+}
+
+// Próxima mensagem de um canal SOCK_SEQPACKET: o datagrama chega sempre
+// inteiro numa só leitura, sem risco de leituras parciais
+static int receive_board_packet(struct Session* s, Board* board, int timeout_ms) {
+    struct timespec deadline;
+    wait_deadline(&deadline, timeout_ms);
+
+    while (1) {
+        ssize_t len = recv_packet(s->notif_pipe, &s->packet, &s->packet_cap);
+        if (len == 0) {
+            // Servidor fechou o canal -> sinalizar fim de jogo
+            return RECEIVE_CLOSED;
+        }
+        if (len > 0) {
+            if (parse_board_message(s, s->packet, len, board) == 0) return RECEIVE_BOARD;
+            continue;   // mensagem inválida: esperar pela seguinte
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            return RECEIVE_NONE;
+        }
+        if (timeout_ms == 0 || !wait_readable(s, &deadline, timeout_ms)) {
+            return RECEIVE_NONE;
+        }
+    }
+}
+
+// Tamanho da mensagem no início de buf: 0 se ainda faltam bytes para o
+// saber, -1 se não é uma mensagem válida
+static ssize_t stream_message_size(const char* buf, size_t len) {
+    if (len < 1) return 0;
+
+    if (buf[0] == OP_CODE_BOARD) {
+        if (len < 1 + 2 * sizeof(int)) return 0;
+        int width, height;
+        memcpy(&width, buf + 1, sizeof(int));
+        memcpy(&height, buf + 1 + sizeof(int), sizeof(int));
+        if (width <= 0 || height <= 0 || (long)width * height > STREAM_MAX_CELLS) return -1;
+        return 1 + 6 * (ssize_t)sizeof(int) + (ssize_t)width * height;
+    }
+
+    if (buf[0] == OP_CODE_BOARD_DELTA) {
+        if (len < 1 + 4 * sizeof(int)) return 0;
+        int n_changes;
+        memcpy(&n_changes, buf + 1 + 3 * sizeof(int), sizeof(int));
+        if (n_changes < 0 || n_changes > STREAM_MAX_CELLS) return -1;
+        return 1 + 4 * (ssize_t)sizeof(int) + (ssize_t)n_changes * DELTA_ENTRY_SIZE;
+    }
+
+    return -1;
+}
+
+// Garante espaço para ler pelo menos want bytes depois dos já guardados
+// (os bytes já interpretados são descartados primeiro)
+static int stream_reserve(struct Session* s, size_t want) {
+    if (s->roff > 0) {
+        memmove(s->rbuf, s->rbuf + s->roff, s->rlen - s->roff);
+        s->rlen -= s->roff;
+        s->roff = 0;
+    }
+    if (s->rcap - s->rlen >= want) return 0;
+
+    char* grown = realloc(s->rbuf, s->rlen + want);
+    if (!grown) {
         debug("Erro de alocação de memória\n");
-        return board;
+        return -1;
     }
-    
-    if (read(session.notif_pipe, board.data, board_size) != board_size) {
-        debug("Erro ao ler dados do tabuleiro\n");
-        free(board.data);
-        board.data = NULL;
-        return board;
+    s->rbuf = grown;
+    s->rcap = s->rlen + want;
+    return 0;
+}
+
+// FIFO de notificações: lê o que houver para o buffer da sessão e entrega
+// uma frame quando estiver completa (mesmo que tenha chegado aos bocados)
+static int receive_board_stream(struct Session* s, Board* board, int timeout_ms) {
+    struct timespec deadline;
+    wait_deadline(&deadline, timeout_ms);
+
+    while (1) {
+        size_t available = s->rlen - s->roff;
+        ssize_t size = stream_message_size(s->rbuf + s->roff, available);
+        if (size < 0) {
+            // Byte que não começa nenhuma mensagem: saltar e ressincronizar
+            debug("Código de operação inválido: %d\n", s->rbuf[s->roff]);
+            s->roff++;
+            continue;
+        }
+        if (size > 0 && available >= (size_t)size) {
+            int parsed = parse_board_message(s, s->rbuf + s->roff, size, board);
+            s->roff += size;
+            if (s->roff == s->rlen) s->roff = s->rlen = 0;
+            if (parsed == 0) return RECEIVE_BOARD;
+            continue;
+        }
+
+        // Ler de uma vez o resto da frame (e o que mais houver no FIFO)
+        size_t missing = size > 0 ? (size_t)size - available : 0;
+        if (stream_reserve(s, missing > STREAM_READ_CHUNK ? missing : STREAM_READ_CHUNK) < 0) {
+            return RECEIVE_NONE;
+        }
+        ssize_t n = read(s->notif_pipe, s->rbuf + s->rlen, s->rcap - s->rlen);
+        if (n > 0) {
+            s->rlen += n;
+            continue;
+        }
+        if (n == 0) {
+            // EOF: servidor fechou pipe -> sinalizar fim de jogo
+            return RECEIVE_CLOSED;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            return RECEIVE_NONE;
+        }
+        if (timeout_ms == 0 || !wait_readable(s, &deadline, timeout_ms)) {
+            return RECEIVE_NONE;
+        }
+    }
+}
+
+// Próximo tabuleiro para *board, esperando até timeout_ms (0: não bloqueia,
+// < 0: sem limite)
+static int session_receive_into(struct Session* s, Board* board, int timeout_ms) {
+    if (s->notif_pipe == -1 || s->mux) {
+        return RECEIVE_NONE;
+    }
+
+    if (s->ring) {
+        return receive_board_shm_into(s, board, timeout_ms);
+    }
+    if (s->seqpacket) {
+        return receive_board_packet(s, board, timeout_ms);
+    }
+    return receive_board_stream(s, board, timeout_ms);
+}
+
+// Como session_receive_into, num tabuleiro novo (com memória partilhada
+// aponta diretamente para a frame no anel)
+static Board session_receive(struct Session* s, int timeout_ms) {
+    Board board = {0};
+
+    if (s->ring && s->notif_pipe != -1 && !s->mux) {
+        return receive_board_shm(s, timeout_ms);
+    }
+    if (session_receive_into(s, &board, timeout_ms) == RECEIVE_CLOSED) {
+        board.game_over = 1;
+    }
+    return board;
+}
+
+static void session_cancel(struct Session* s) {
+    atomic_store(&s->cancelled, 1);
+    if (s->wake_fds[1] != -1) {
+        char byte = 1;
+        if (write(s->wake_fds[1], &byte, 1) < 0) {
+            // Pipe cheio: já há um despertar pendente
+        }
+    }
+    if (s->ring) shm_ring_wake(s->ring);
+}
+
+// ==================== API ORIGINAL (SESSÃO ÚNICA) ====================
+
+int pacman_connect(char const *req_pipe_path, char const *notif_pipe_path, char const *server_pipe_path) {
+    return session_connect(&session, req_pipe_path, notif_pipe_path, server_pipe_path, TRANSPORT_PIPE);
+}
+
+int pacman_connect_ex(char const *req_pipe_path, char const *notif_pipe_path, char const *server_pipe_path,
+                      int transport) {
+    return session_connect(&session, req_pipe_path, notif_pipe_path, server_pipe_path, transport);
+}
+
+int pacman_connect_unix(char const *socket_path, int client_id, int transport) {
+    return session_connect_unix(&session, socket_path, client_id, transport);
+}
+
+int pacman_transport(void) {
+    return session.transport;
+}
+
+void pacman_play(char command) {
+    session_play(&session, command);
+}
+
+int pacman_play_batch(play_cmd_t const* cmds, int n) {
+    return session_play_batch(&session, cmds, n);
+}
+
+int pacman_disconnect() {
+    return session_disconnect(&session);
+}
+
+Board receive_board_update(void) {
+    return session_receive(&session, 0);
+}
+
+Board receive_board_wait(int timeout_ms) {
+    return session_receive(&session, timeout_ms);
+}
+
+int receive_board_into(Board* board, int timeout_ms) {
+    return session_receive_into(&session, board, timeout_ms);
+}
+
+void receive_board_cancel(void) {
+    session_cancel(&session);
+}
+
+void release_board(Board* board) {
+    session_release_board(&session, board);
+}
+
+// ==================== SESSÕES POR HANDLE ====================
+
+pacman_session_t* pacman_session_connect(char const *req_pipe_path, char const *notif_pipe_path,
+                                         char const *server_pipe_path, int transport) {
+    struct Session* s = malloc(sizeof(struct Session));
+    if (!s) return NULL;
+    session_init(s);
+    if (session_connect(s, req_pipe_path, notif_pipe_path, server_pipe_path, transport) != 0) {
+        free(s);
+        return NULL;
+    }
+    return s;
+}
+
+pacman_session_t* pacman_session_connect_unix(char const *socket_path, int client_id, int transport) {
+    struct Session* s = malloc(sizeof(struct Session));
+    if (!s) return NULL;
+    session_init(s);
+    if (session_connect_unix(s, socket_path, client_id, transport) != 0) {
+        free(s);
+        return NULL;
+    }
+    s->id = client_id;
+    return s;
+}
+
+int pacman_session_id(pacman_session_t const *s) {
+    return s->id;
+}
+
+int pacman_session_transport(pacman_session_t const *s) {
+    return s->transport;
+}
+
+int pacman_session_fd(pacman_session_t const *s) {
+    return s->mux ? -1 : s->notif_pipe;
+}
+
+void pacman_session_play(pacman_session_t *s, char command) {
+    session_play(s, command);
+}
+
+int pacman_session_play_batch(pacman_session_t *s, play_cmd_t const *cmds, int n) {
+    return session_play_batch(s, cmds, n);
+}
+
+Board pacman_session_receive(pacman_session_t *s) {
+    return session_receive(s, 0);
+}
+
+Board pacman_session_wait(pacman_session_t *s, int timeout_ms) {
+    return session_receive(s, timeout_ms);
+}
+
+int pacman_session_receive_into(pacman_session_t *s, Board *board, int timeout_ms) {
+    return session_receive_into(s, board, timeout_ms);
+}
+
+void pacman_session_cancel(pacman_session_t *s) {
+    session_cancel(s);
+}
+
+void pacman_session_release_board(pacman_session_t *s, Board *board) {
+    session_release_board(s, board);
+}
+
+static void mux_forget(struct pacman_mux* mux, struct Session* s) {
+    mux->sessions[s->id] = NULL;
+    free(s->grid);
+    free(s);
+}
+
+int pacman_session_disconnect(pacman_session_t *s) {
+    if (!s->mux) {
+        int result = session_disconnect(s);
+        free(s);
+        return result;
+    }
+
+    // Num canal multiplexado o session_id só fica livre quando o servidor
+    // confirmar o fim (até lá chegam as últimas frames, que se descartam)
+    if (s->mux_state == MUX_CLOSED) {
+        mux_forget(s->mux, s);
+        return 0;
+    }
+
+    char op_code = OP_CODE_DISCONNECT;
+    int result = session_send(s, &op_code, 1) < 0;
+    s->mux_state = MUX_CLOSING;
+    debug("Desconexão pedida para a sessão %d\n", s->id);
+    return result;
+}
+
+// ==================== CANAL MULTIPLEXADO ====================
+
+pacman_mux_t* pacman_mux_connect(char const *socket_path, int client_id) {
+    struct pacman_mux* mux = calloc(1, sizeof(struct pacman_mux));
+    if (!mux) return NULL;
+    mux->sessions = calloc(MUX_MAX_SESSIONS, sizeof(struct Session*));
+    if (!mux->sessions) {
+        free(mux);
+        return NULL;
+    }
+
+    int fds[2];
+    char response[3 + SHM_NAME_FIELD_LENGTH];
+    int connected = socket_handshake(socket_path, client_id, TRANSPORT_MUX, fds, response) == 0;
+    if (!connected || response[2] != TRANSPORT_MUX) {
+        // Servidor sem canais multiplexados: respondeu como a uma sessão
+        if (connected) {
+            debug("O servidor não aceitou o canal multiplexado\n");
+            close(fds[0]);
+            close(fds[1]);
+        }
+        free(mux->sessions);
+        free(mux);
+        return NULL;
+    }
+
+    mux->req_fd = fds[0];
+    mux->notif_fd = fds[1];
+    debug("Canal multiplexado estabelecido\n");
+    return mux;
+}
+
+// Próximo datagrama do canal: primeiro os guardados, depois o socket. Devolve
+// o tamanho (dados em mux->packet), 0 se o canal fechou ou -1 sem dados.
+static ssize_t mux_next_packet(struct pacman_mux* mux) {
+    mux_pending_t* pending = mux->pending_head;
+    if (!pending) return recv_packet(mux->notif_fd, &mux->packet, &mux->packet_cap);
+
+    mux->pending_head = pending->next;
+    if (!mux->pending_head) mux->pending_tail = NULL;
+
+    ssize_t len = pending->len;
+    if ((size_t)len > mux->packet_cap) {
+        char* grown = realloc(mux->packet, len);
+        if (!grown) {
+            free(pending);
+            return -1;
+        }
+        mux->packet = grown;
+        mux->packet_cap = len;
+    }
+    memcpy(mux->packet, pending->data, len);
+    free(pending);
+    return len;
+}
+
+static void mux_keep_packet(struct pacman_mux* mux, ssize_t len) {
+    mux_pending_t* pending = malloc(sizeof(mux_pending_t) + len);
+    if (!pending) {
+        debug("Erro de alocação de memória: datagrama descartado\n");
+        return;
+    }
+    pending->next = NULL;
+    pending->len = len;
+    memcpy(pending->data, mux->packet, len);
+    if (mux->pending_tail) mux->pending_tail->next = pending;
+    else mux->pending_head = pending;
+    mux->pending_tail = pending;
+}
+
+pacman_session_t* pacman_mux_open_session(pacman_mux_t *mux, int session_id) {
+    if (session_id < 0 || session_id >= MUX_MAX_SESSIONS || mux->sessions[session_id]) {
+        debug("session_id inválido ou ainda em uso: %d\n", session_id);
+        return NULL;
+    }
+
+    struct Session* s = malloc(sizeof(struct Session));
+    if (!s) return NULL;
+    session_init(s);
+    s->id = session_id;
+    s->mux = mux;
+    s->mux_state = MUX_CONNECTING;
+    s->req_pipe = mux->req_fd;
+    s->notif_pipe = mux->notif_fd;
+    mux->sessions[session_id] = s;
+
+    char op_code = OP_CODE_CONNECT;
+    if (session_send(s, &op_code, 1) < 0) {
+        mux_forget(mux, s);
+        return NULL;
+    }
+
+    // Esperar pela resposta; as frames das outras sessões que chegarem
+    // entretanto ficam guardadas para pacman_mux_receive
+    while (1) {
+        ssize_t len = recv_packet(mux->notif_fd, &mux->packet, &mux->packet_cap);
+        if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            struct pollfd pfd = {mux->notif_fd, POLLIN, 0};
+            poll(&pfd, 1, -1);
+            continue;
+        }
+        if (len <= 0) break;
+
+        int id = -1;
+        const char* inner = mux->packet + MUX_HEADER_SIZE;
+        if (len > MUX_HEADER_SIZE) memcpy(&id, mux->packet + 1, sizeof(int));
+        if (len == MUX_HEADER_SIZE + 3 + SHM_NAME_FIELD_LENGTH && id == session_id &&
+            inner[0] == OP_CODE_CONNECT) {
+            if (inner[1] != 0) break;
+            s->mux_state = MUX_OPEN;
+            return s;
+        }
+        mux_keep_packet(mux, len);
+    }
+
+    debug("Sessão %d recusada pelo servidor\n", session_id);
+    mux_forget(mux, s);
+    return NULL;
+}
+
+int pacman_mux_receive_into(pacman_mux_t *mux, pacman_session_t **from, Board *board) {
+    *from = NULL;
+
+    while (1) {
+        ssize_t len = mux_next_packet(mux);
+        if (len < 0) return RECEIVE_NONE;
+        if (len == 0) {
+            // O servidor fechou o canal: fim de todas as sessões
+            return RECEIVE_CLOSED;
+        }
+
+        int id;
+        if (len <= MUX_HEADER_SIZE || mux->packet[0] != OP_CODE_MUX) continue;
+        memcpy(&id, mux->packet + 1, sizeof(int));
+        if (id < 0 || id >= MUX_MAX_SESSIONS || !mux->sessions[id]) continue;
+
+        struct Session* s = mux->sessions[id];
+        const char* inner = mux->packet + MUX_HEADER_SIZE;
+        if (inner[0] == OP_CODE_DISCONNECT) {
+            // Fim da sessão: liberta-a já se o cliente também a tinha fechado
+            if (s->mux_state == MUX_CLOSING) {
+                mux_forget(mux, s);
+                continue;
+            }
+            s->mux_state = MUX_CLOSED;
+            *from = s;
+            return RECEIVE_CLOSED;
+        }
+        if (s->mux_state != MUX_OPEN) continue;
+
+        if (parse_board_message(s, inner, len - MUX_HEADER_SIZE, board) < 0) continue;
+        *from = s;
+        return RECEIVE_BOARD;
+    }
+}
+
+Board pacman_mux_receive(pacman_mux_t *mux, pacman_session_t **from) {
+    Board board = {0};
+    if (pacman_mux_receive_into(mux, from, &board) == RECEIVE_CLOSED) {
+        board.game_over = 1;
     }
-    
-    board.data[board_size] = '\0';
-    
     return board;
-}
\ No newline at end of file
+}
+
+void pacman_mux_disconnect(pacman_mux_t *mux) {
+    // Fechar os canais termina no servidor todas as sessões ainda abertas
+    close(mux->req_fd);
+    close(mux->notif_fd);
+
+    for (int i = 0; i < MUX_MAX_SESSIONS; i++) {
+        if (mux->sessions[i]) mux_forget(mux, mux->sessions[i]);
+    }
+    while (mux->pending_head) {
+        mux_pending_t* next = mux->pending_head->next;
+        free(mux->pending_head);
+        mux->pending_head = next;
+    }
+    free(mux->sessions);
+    free(mux->packet);
+    free(mux);
+    debug("Canal multiplexado fechado\n");
+}
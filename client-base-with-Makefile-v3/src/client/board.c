@@ -1,12 +1,36 @@
 #include "board.h"
 #include "parser.h"
+#include "level_cache.h"
 #include <stdlib.h>
+#include <string.h>
 #include <stdio.h> //snprintf
 #include <fcntl.h>
 #include <time.h>
 #include <unistd.h>
 #include <pthread.h>
 
+// Helper private function for the char a cell shows (charged: ghost in the cell is charged)
+static inline char cell_glyph(const board_t* board, int index, int charged) {
+    char content = board_content(board, index);
+    switch (content) {
+        case 'W': return '#';
+        case 'P': return 'C';
+        case 'M': return charged ? 'G' : 'M';
+        case ' ':
+            if (board_has_portal(board, index)) return '@';
+            if (board_has_dot(board, index)) return '.';
+            return ' ';
+        default: return content;
+    }
+}
+
+// Helper private function to refresh one cell of the render buffer
+static inline void display_cell(board_t* board, int index, int charged) {
+    if (board->display) {
+        board->display[index] = cell_glyph(board, index, charged);
+    }
+}
+
 // Helper private function to find and kill pacman at specific position
 static int find_and_kill_pacman(board_t* board, int new_x, int new_y) {
     for (int p = 0; p < board->n_pacmans; p++) {
@@ -88,55 +112,50 @@ int move_pacman(board_t* board, int pacman_index, command_t* command) {
     int new_index = get_board_index(board, new_x, new_y);
     int old_index = get_board_index(board, pac->pos_x, pac->pos_y);
 
-    // locks - acquire in consistent order
-    if (old_index < new_index) {
-        pthread_mutex_lock(&board->board[old_index].lock);
-        pthread_mutex_lock(&board->board[new_index].lock);
-    }
-    else {
-        pthread_mutex_lock(&board->board[new_index].lock);
-        pthread_mutex_lock(&board->board[old_index].lock);
-    }
+    // locks - acquired in a consistent order
+    board_lock_cells(board, old_index, new_index);
 
-    char target_content = board->board[new_index].content;
+    char target_content = board_content(board, new_index);
 
     // Check for portal
-    if (board->board[new_index].has_portal) {
-        board->board[old_index].content = ' ';
-        board->board[new_index].content = 'P';
-        pthread_mutex_unlock(&board->board[old_index].lock);
-        pthread_mutex_unlock(&board->board[new_index].lock);
+    if (board_has_portal(board, new_index)) {
+        board_set_content(board, old_index, ' ');
+        board_set_content(board, new_index, 'P');
+        display_cell(board, old_index, 0);
+        display_cell(board, new_index, 0);
+        board->portal_reached = 1;
+        board_unlock_cells(board, old_index, new_index);
         return REACHED_PORTAL;
     }
 
     // Check for walls
     if (target_content == 'W') {
-        pthread_mutex_unlock(&board->board[old_index].lock);
-        pthread_mutex_unlock(&board->board[new_index].lock);
+        board_unlock_cells(board, old_index, new_index);
         return INVALID_MOVE;
     }
 
     // Check for ghosts
     if (target_content == 'M') {
         kill_pacman(board, pacman_index);
-        pthread_mutex_unlock(&board->board[old_index].lock);
-        pthread_mutex_unlock(&board->board[new_index].lock);
+        board_unlock_cells(board, old_index, new_index);
         return DEAD_PACMAN;
     }
 
     // Collect points
-    if (board->board[new_index].has_dot) {
+    if (board_has_dot(board, new_index)) {
         pac->points++;
-        board->board[new_index].has_dot = 0;
+        board_set_dot(board, new_index, 0);
+        board->dots_left--;
     }
 
-    board->board[old_index].content = ' ';
+    board_set_content(board, old_index, ' ');
     pac->pos_x = new_x;
     pac->pos_y = new_y;
-    board->board[new_index].content = 'P';
+    board_set_content(board, new_index, 'P');
+    display_cell(board, old_index, 0);
+    display_cell(board, new_index, 0);
 
-    pthread_mutex_unlock(&board->board[old_index].lock);
-    pthread_mutex_unlock(&board->board[new_index].lock);
+    board_unlock_cells(board, old_index, new_index);
 
     return VALID_MOVE;
 }
@@ -150,19 +169,18 @@ int move_ghost_charged(board_t* board, int ghost_index, char direction) {
     int result;
 
     ghost->charged = 0;
+    display_cell(board, y * board->width + x, 0);
 
     switch (direction) {
         case 'W':
             if (y == 0) return INVALID_MOVE;
 
-            for (int i = 0; i <= y; i++) {
-                pthread_mutex_lock(&board->board[i * board->width + x].lock);
-            }
+            board_lock_line(board, x, y + 1, board->width);
 
             new_y = 0;
             result = VALID_MOVE;
             for (int i = y - 1; i >= 0; i--) {
-                char target_content = board->board[i * board->width + x].content;
+                char target_content = board_content(board, i * board->width + x);
                 if (target_content == 'W' || target_content == 'M') {
                     new_y = i + 1;
                     result = VALID_MOVE;
@@ -175,21 +193,17 @@ int move_ghost_charged(board_t* board, int ghost_index, char direction) {
                 }
             }
 
-            for (int i = 0; i <= y; i++) {
-                pthread_mutex_unlock(&board->board[i * board->width + x].lock);
-            }
+            board_unlock_line(board, x, y + 1, board->width);
             break;
         case 'S':
             if (y == board->height - 1) return INVALID_MOVE;
 
-            for (int i = y; i < board->height; i++) {
-                pthread_mutex_lock(&board->board[i * board->width + x].lock);
-            }
+            board_lock_line(board, y * board->width + x, board->height - y, board->width);
 
             new_y = board->height - 1;
             result = VALID_MOVE;
             for (int i = y + 1; i < board->height; i++) {
-                char target_content = board->board[i * board->width + x].content;
+                char target_content = board_content(board, i * board->width + x);
                 if (target_content == 'W' || target_content == 'M') {
                     new_y = i - 1;
                     result = VALID_MOVE;
@@ -202,21 +216,17 @@ int move_ghost_charged(board_t* board, int ghost_index, char direction) {
                 }
             }
 
-            for (int i = y; i < board->height; i++) {
-                pthread_mutex_unlock(&board->board[i * board->width + x].lock);
-            }
+            board_unlock_line(board, y * board->width + x, board->height - y, board->width);
             break;
         case 'A':
             if (x == 0) return INVALID_MOVE;
 
-            for (int j = 0; j <= x; j++) {
-                pthread_mutex_lock(&board->board[y * board->width + j].lock);
-            }
+            board_lock_line(board, y * board->width, x + 1, 1);
 
             new_x = 0;
             result = VALID_MOVE;
             for (int j = x - 1; j >= 0; j--) {
-                char target_content = board->board[y * board->width + j].content;
+                char target_content = board_content(board, y * board->width + j);
                 if (target_content == 'W' || target_content == 'M') {
                     new_x = j + 1;
                     result = VALID_MOVE;
@@ -229,21 +239,17 @@ int move_ghost_charged(board_t* board, int ghost_index, char direction) {
                 }
             }
 
-            for (int j = 0; j <= x; j++) {
-                pthread_mutex_unlock(&board->board[y * board->width + j].lock);
-            }
+            board_unlock_line(board, y * board->width, x + 1, 1);
             break;
         case 'D':
             if (x == board->width - 1) return INVALID_MOVE;
 
-            for (int j = x; j < board->width; j++) {
-                pthread_mutex_lock(&board->board[y * board->width + j].lock);
-            }
+            board_lock_line(board, y * board->width + x, board->width - x, 1);
 
             new_x = board->width - 1;
             result = VALID_MOVE;
             for (int j = x + 1; j < board->width; j++) {
-                char target_content = board->board[y * board->width + j].content;
+                char target_content = board_content(board, y * board->width + j);
                 if (target_content == 'W' || target_content == 'M') {
                     new_x = j - 1;
                     result = VALID_MOVE;
@@ -256,19 +262,19 @@ int move_ghost_charged(board_t* board, int ghost_index, char direction) {
                 }
             }
 
-            for (int j = x; j < board->width; j++) {
-                pthread_mutex_unlock(&board->board[y * board->width + j].lock);
-            }
+            board_unlock_line(board, y * board->width + x, board->width - x, 1);
             break;
         default:
             return INVALID_MOVE;
     }
 
-    board->board[y * board->width + x].content = ' ';
+    board_set_content(board, y * board->width + x, ' ');
+    display_cell(board, y * board->width + x, 0);
 
     ghost->pos_x = new_x;
     ghost->pos_y = new_y;
-    board->board[new_y * board->width + new_x].content = 'M';
+    board_set_content(board, new_y * board->width + new_x, 'M');
+    display_cell(board, new_y * board->width + new_x, 0);
     return result;
 }
 
@@ -308,6 +314,7 @@ int move_ghost(board_t* board, int ghost_index, command_t* command) {
         case 'C': // Charge
             ghost->current_move += 1;
             ghost->charged = 1;
+            display_cell(board, ghost->pos_y * board->width + ghost->pos_x, 1);
             return VALID_MOVE;
         case 'T':
             if (command->turns_left == 1) {
@@ -332,29 +339,20 @@ int move_ghost(board_t* board, int ghost_index, command_t* command) {
     int new_index = new_y * board->width + new_x;
     int old_index = ghost->pos_y * board->width + ghost->pos_x;
 
-    // locks
-    if (old_index < new_index) {
-        pthread_mutex_lock(&board->board[old_index].lock);
-        pthread_mutex_lock(&board->board[new_index].lock);
-    }
-    else {
-        pthread_mutex_lock(&board->board[new_index].lock);
-        pthread_mutex_lock(&board->board[old_index].lock);
-    }
+    // locks - acquired in a consistent order
+    board_lock_cells(board, old_index, new_index);
 
-    char target_content = board->board[new_index].content;
+    char target_content = board_content(board, new_index);
 
     // Check for walls
     if (target_content == 'W') {
-        pthread_mutex_unlock(&board->board[old_index].lock);
-        pthread_mutex_unlock(&board->board[new_index].lock);
+        board_unlock_cells(board, old_index, new_index);
         return INVALID_MOVE;
     }
 
     // Check for ghosts
     if (target_content == 'M') {
-        pthread_mutex_unlock(&board->board[old_index].lock);
-        pthread_mutex_unlock(&board->board[new_index].lock);
+        board_unlock_cells(board, old_index, new_index);
         return INVALID_MOVE;
     }
 
@@ -372,13 +370,14 @@ int move_ghost(board_t* board, int ghost_index, command_t* command) {
         }
     }
 
-    board->board[old_index].content = ' ';
+    board_set_content(board, old_index, ' ');
     ghost->pos_x = new_x;
     ghost->pos_y = new_y;
-    board->board[new_index].content = 'M';
+    board_set_content(board, new_index, 'M');
+    display_cell(board, old_index, 0);
+    display_cell(board, new_index, 0);
 
-    pthread_mutex_unlock(&board->board[old_index].lock);
-    pthread_mutex_unlock(&board->board[new_index].lock);
+    board_unlock_cells(board, old_index, new_index);
 
     return result;
 }
@@ -387,12 +386,13 @@ void kill_pacman(board_t* board, int pacman_index) {
     pacman_t* pac = &board->pacmans[pacman_index];
     int index = pac->pos_y * board->width + pac->pos_x;
 
-    board->board[index].content = ' ';
+    board_set_content(board, index, ' ');
+    display_cell(board, index, 0);
     pac->alive = 0;
 }
 
 int load_pacman(board_t* board) {
-    board->board[1 * board->width + 1].content = 'P';
+    board_set_content(board, 1 * board->width + 1, 'P');
     board->pacmans[0].pos_x = 1;
     board->pacmans[0].pos_y = 1;
     board->pacmans[0].alive = 1;
@@ -401,16 +401,59 @@ int load_pacman(board_t* board) {
 }
 
 int load_ghost(board_t* board) {
-    board->board[4 * board->width + 8].content = 'M';
+    board_set_content(board, 4 * board->width + 8, 'M');
     board->ghosts[0].pos_x = 8;
     board->ghosts[0].pos_y = 4;
-    board->board[0 * board->width + 5].content = 'M';
+    board_set_content(board, 0 * board->width + 5, 'M');
     board->ghosts[1].pos_x = 5;
     board->ghosts[1].pos_y = 0;
     return 0;
 }
 
+int load_level_from(board_t* board, const board_t* level, int points) {
+    *board = *level;
+    int cells_ok = board_copy_cells(board, level) == 0;
+    board->pacmans = malloc(level->n_pacmans * sizeof(pacman_t));
+    board->ghosts = malloc(level->n_ghosts * sizeof(ghost_t));
+    if (!cells_ok || !board->pacmans || (level->n_ghosts && !board->ghosts)) {
+        if (cells_ok) board_free_cells(board);
+        free(board->pacmans);
+        free(board->ghosts);
+        return -1;
+    }
+
+    memcpy(board->pacmans, level->pacmans, level->n_pacmans * sizeof(pacman_t));
+    memcpy(board->ghosts, level->ghosts, level->n_ghosts * sizeof(ghost_t));
+    board->pacmans[0].points = points;
+    board->dots_left = level->n_dots;
+    board->portal_reached = 0;
+
+    // Compiled levels carry their rendered board: copy it instead of rebuilding
+    board->display = NULL;
+    if (level->display) {
+        board->display = malloc(level->width * level->height);
+        if (board->display) memcpy(board->display, level->display, level->width * level->height);
+    }
+    if (!board->display && board_display_rebuild(board) < 0) {
+        board_free_cells(board);
+        free(board->pacmans);
+        free(board->ghosts);
+        return -1;
+    }
+
+    pthread_rwlock_init(&board->state_lock, NULL);
+    board_init_locks(board);
+
+    return 0;
+}
+
 int load_level(board_t* board, char* filename, char* dirname, int points) {
+    // Nível já compilado no arranque: basta copiá-lo
+    const board_t* cached = level_cache_find(dirname, filename);
+    if (cached) {
+        return load_level_from(board, cached, points);
+    }
+
     if (read_level(board, filename, dirname) < 0) {
         return -1;
     }
@@ -421,22 +464,215 @@ int load_level(board_t* board, char* filename, char* dirname, int points) {
     if (read_ghosts(board) < 0) {
     }
 
-    pthread_rwlock_init(&board->state_lock, NULL);
-
-    for (int i = 0; i < board->height * board->width; i++) {
-        pthread_mutex_init(&board->board[i].lock, NULL);
+    board->display = NULL;
+    if (board_display_rebuild(board) < 0) {
+        return -1;
     }
 
+    pthread_rwlock_init(&board->state_lock, NULL);
+    board_init_locks(board);
+
     return 0;
 }
 
 void unload_level(board_t* board) {
     pthread_rwlock_destroy(&board->state_lock);
+    board_destroy_locks(board);
+    board_free_cells(board);
+    free(board->pacmans);
+    free(board->ghosts);
+    free(board->display);
+    board->display = NULL;
+}
+
+int board_display_rebuild(board_t* board) {
+    int cells = board->width * board->height;
+    if (!board->display) {
+        board->display = malloc(cells);
+        if (!board->display) return -1;
+    }
+
+    for (int i = 0; i < cells; i++) {
+        board->display[i] = cell_glyph(board, i, 0);
+    }
+
+    // Only the ghosts' own cells depend on the charged flag
+    for (int g = 0; g < board->n_ghosts; g++) {
+        ghost_t* ghost = &board->ghosts[g];
+        int index = get_board_index(board, ghost->pos_x, ghost->pos_y);
+        if (ghost->charged && board_content(board, index) == 'M') {
+            board->display[index] = 'G';
+        }
+    }
+    return 0;
+}
+
+// Cell storage and locking for both layouts
+
+#ifndef BOARD_COMPACT
+
+int board_alloc_cells(board_t* board) {
+    board->board = calloc(board->width * board->height, sizeof(board_pos_t));
+    return board->board ? 0 : -1;
+}
+
+int board_copy_cells(board_t* dst, const board_t* src) {
+    int cells = src->width * src->height;
+    dst->board = malloc(cells * sizeof(board_pos_t));
+    if (!dst->board) return -1;
+    memcpy(dst->board, src->board, cells * sizeof(board_pos_t));
+    return 0;
+}
+
+void board_free_cells(board_t* board) {
+    free(board->board);
+    board->board = NULL;
+}
+
+size_t board_cells_bytes(const board_t* board) {
+    return (size_t)board->width * board->height * sizeof(board_pos_t);
+}
+
+void board_init_locks(board_t* board) {
+    for (int i = 0; i < board->height * board->width; i++) {
+        pthread_mutex_init(&board->board[i].lock, NULL);
+    }
+}
+
+void board_destroy_locks(board_t* board) {
     for (int i = 0; i < board->height * board->width; i++) {
         pthread_mutex_destroy(&board->board[i].lock);
     }
-    free(board->board);
-    free(board->pacmans);
-    free(board->ghosts);
 }
 
+void board_lock_cells(board_t* board, int a, int b) {
+    if (a > b) {
+        int tmp = a;
+        a = b;
+        b = tmp;
+    }
+    pthread_mutex_lock(&board->board[a].lock);
+    if (b != a) pthread_mutex_lock(&board->board[b].lock);
+}
+
+void board_unlock_cells(board_t* board, int a, int b) {
+    pthread_mutex_unlock(&board->board[a].lock);
+    if (b != a) pthread_mutex_unlock(&board->board[b].lock);
+}
+
+// start is always the lowest index of the line, so cells are locked in ascending order
+void board_lock_line(board_t* board, int start, int count, int stride) {
+    for (int i = 0; i < count; i++) {
+        pthread_mutex_lock(&board->board[start + i * stride].lock);
+    }
+}
+
+void board_unlock_line(board_t* board, int start, int count, int stride) {
+    for (int i = 0; i < count; i++) {
+        pthread_mutex_unlock(&board->board[start + i * stride].lock);
+    }
+}
+
+#else
+
+// Helper private function for the number of 64 bit words of a cell bitset
+static inline int bitset_words(const board_t* board) {
+    return (board->width * board->height + 63) / 64;
+}
+
+// Helper private function for the lock covering a cell: each region of
+// BOARD_LOCK_REGION consecutive cells (one bitset word) shares a lock, so the
+// read-modify-write of the dot bitset is protected by the same lock as the cell
+static inline int lock_stripe(int index) {
+    return (index / BOARD_LOCK_REGION) % BOARD_LOCK_STRIPES;
+}
+
+// Helper private function that takes every lock of the mask in ascending order
+static void lock_mask(board_t* board, uint64_t mask) {
+    while (mask) {
+        pthread_mutex_lock(&board->locks[__builtin_ctzll(mask)]);
+        mask &= mask - 1;
+    }
+}
+
+static void unlock_mask(board_t* board, uint64_t mask) {
+    while (mask) {
+        pthread_mutex_unlock(&board->locks[__builtin_ctzll(mask)]);
+        mask &= mask - 1;
+    }
+}
+
+static uint64_t line_mask(int start, int count, int stride) {
+    uint64_t mask = 0;
+    for (int i = 0; i < count; i++) {
+        mask |= (uint64_t)1 << lock_stripe(start + i * stride);
+    }
+    return mask;
+}
+
+int board_alloc_cells(board_t* board) {
+    int words = bitset_words(board);
+    board->content = calloc(board->width * board->height, 1);
+    board->dots = calloc(words, sizeof(uint64_t));
+    board->portals = calloc(words, sizeof(uint64_t));
+    if (!board->content || !board->dots || !board->portals) {
+        board_free_cells(board);
+        return -1;
+    }
+    return 0;
+}
+
+int board_copy_cells(board_t* dst, const board_t* src) {
+    dst->width = src->width;
+    dst->height = src->height;
+    if (board_alloc_cells(dst) < 0) return -1;
+    memcpy(dst->content, src->content, src->width * src->height);
+    memcpy(dst->dots, src->dots, bitset_words(src) * sizeof(uint64_t));
+    memcpy(dst->portals, src->portals, bitset_words(src) * sizeof(uint64_t));
+    return 0;
+}
+
+void board_free_cells(board_t* board) {
+    free(board->content);
+    free(board->dots);
+    free(board->portals);
+    board->content = NULL;
+    board->dots = NULL;
+    board->portals = NULL;
+}
+
+size_t board_cells_bytes(const board_t* board) {
+    return (size_t)board->width * board->height +
+           2 * bitset_words(board) * sizeof(uint64_t) +
+           sizeof(board->locks);
+}
+
+void board_init_locks(board_t* board) {
+    for (int s = 0; s < BOARD_LOCK_STRIPES; s++) {
+        pthread_mutex_init(&board->locks[s], NULL);
+    }
+}
+
+void board_destroy_locks(board_t* board) {
+    for (int s = 0; s < BOARD_LOCK_STRIPES; s++) {
+        pthread_mutex_destroy(&board->locks[s]);
+    }
+}
+
+void board_lock_cells(board_t* board, int a, int b) {
+    lock_mask(board, ((uint64_t)1 << lock_stripe(a)) | ((uint64_t)1 << lock_stripe(b)));
+}
+
+void board_unlock_cells(board_t* board, int a, int b) {
+    unlock_mask(board, ((uint64_t)1 << lock_stripe(a)) | ((uint64_t)1 << lock_stripe(b)));
+}
+
+void board_lock_line(board_t* board, int start, int count, int stride) {
+    lock_mask(board, line_mask(start, count, stride));
+}
+
+void board_unlock_line(board_t* board, int start, int count, int stride) {
+    unlock_mask(board, line_mask(start, count, stride));
+}
+
+#endif
@@ -8,86 +8,430 @@
 #include <string.h>
 #include <ctype.h>
 #include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
 #include <unistd.h>
 #include <unistd.h> // usleep
 
-Board board = {0};  // Inicializar estrutura com zeros (data será NULL, width/height 0)
-bool stop_execution = false;
-int tempo = 500;
-pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+atomic_bool stop_execution = false;
+atomic_bool game_closed = false;    // o servidor fechou a sessão sem frame final
+atomic_int tempo = 500;
+bool headless = false;              // -H: sem ncurses, só estatísticas
+
+// Comandos enviados de cada vez com um ficheiro de comandos (o servidor
+// guarda sempre um lote inteiro)
+#define FILE_BATCH_SIZE MAX_PLAY_BATCH
+
+// Lê do ficheiro o próximo lote (comandos iguais seguidos juntam-se num só,
+// com repeat). Volta ao início do ficheiro quando chega ao fim. *quit fica a
+// true se o ficheiro pedir para sair ('Q').
+static int read_command_batch(FILE* fp, play_cmd_t* batch, int max, bool* quit) {
+    int n = 0;
+    int rewound = 0;
+
+    while (n < max) {
+        int ch = fgetc(fp);
+        if (ch == EOF) {
+            // Lote parcial no fim do ficheiro: enviar já o que há
+            if (n > 0 || rewound) break;
+            rewind(fp);
+            rewound = 1;
+            continue;
+        }
 
-static void* receiver_thread(void* arg) {
-    (void)arg;
+        char command = (char)toupper(ch);
+        if (command == '\n' || command == '\r' || command == '\0')
+            continue;
 
-    while (true) {
-        // Verificar se já foi pedido para parar (por exemplo, tecla 'Q')
-        pthread_mutex_lock(&mutex);
-        if (stop_execution) {
-            pthread_mutex_unlock(&mutex);
+        if (command == 'Q') {
+            *quit = true;
             break;
         }
-        pthread_mutex_unlock(&mutex);
 
-        Board new_board = receive_board_update();
+        if (n > 0 && batch[n - 1].command == command) {
+            batch[n - 1].repeat++;
+        } else {
+            batch[n].command = command;
+            batch[n].repeat = 1;
+            n++;
+        }
+    }
+    return n;
+}
+
+// ==================== TRIPLO BUFFER ====================
+
+// O recetor descodifica sempre no seu slot e publica-o trocando-o com o do
+// meio; a thread de desenho troca o seu com o do meio quando há uma frame
+// nova. Nenhum dos lados espera pelo outro: frames que chegam mais depressa
+// do que o terminal as mostra são simplesmente substituídas.
+#define FRAME_FRESH 4   // bit em frames.middle: o slot do meio ainda não foi desenhado
+
+static struct {
+    Board slots[3];
+    atomic_int middle;      // índice do slot do meio (| FRAME_FRESH)
+    sem_t ready;            // acorda a thread de desenho
+} frames = {.middle = 1};
+
+// Publica o slot *back (do recetor) e fica com o antigo slot do meio
+static void frame_publish(int* back) {
+    *back = atomic_exchange(&frames.middle, *back | FRAME_FRESH) & ~FRAME_FRESH;
+    sem_post(&frames.ready);
+}
+
+// Troca o slot *front (de desenho) pelo do meio, se este tiver uma frame nova
+static bool frame_take(int* front) {
+    if (!(atomic_load(&frames.middle) & FRAME_FRESH)) return false;
+    *front = atomic_exchange(&frames.middle, *front) & ~FRAME_FRESH;
+    return true;
+}
+
+static void request_stop(void) {
+    atomic_store(&stop_execution, true);
+    sem_post(&frames.ready);
+}
+
+// ==================== MODO HEADLESS ====================
+
+// Sem ncurses (-H): o guião de comandos é lido todo para memória e enviado um
+// comando por tick; no fim mostram-se as estatísticas da sessão. A thread de
+// receção é a única a tocar em stats até ao pthread_join.
+typedef struct {
+    long* values;   // µs
+    int len;
+    int cap;
+} samples_t;
+
+static struct {
+    long frames;
+    long long first_ns;
+    long long last_ns;
+    samples_t intervals;    // entre frames seguidas
+    samples_t jitter;       // |intervalo - tempo|
+    samples_t echo;         // comando enviado -> primeira frame com o pacman noutro sítio
+    long no_echo;           // comandos sem efeito visível (parede, substituídos)
+    long long command_ns;   // último comando visto pela thread de receção
+    bool echo_waiting;      // ... ainda sem eco
+    int echo_from;          // posição do pacman quando o comando foi enviado
+    int pacman_pos;
+} stats;
+
+// Instante (CLOCK_MONOTONIC) do último comando enviado
+static _Atomic long long command_sent_ns = 0;
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void samples_add(samples_t* s, long value) {
+    if (s->len == s->cap) {
+        int cap = s->cap ? 2 * s->cap : 1024;
+        long* grown = realloc(s->values, cap * sizeof(long));
+        if (!grown) return;
+        s->values = grown;
+        s->cap = cap;
+    }
+    s->values[s->len++] = value;
+}
+
+// Regista uma frame recebida (chamada pela thread de receção)
+static void stats_frame(const Board* frame) {
+    long long now = now_ns();
+    if (stats.frames++ == 0) {
+        stats.first_ns = now;
+    } else {
+        long interval_us = (long)((now - stats.last_ns) / 1000);
+        long jitter_us = interval_us - frame->tempo * 1000L;
+        samples_add(&stats.intervals, interval_us);
+        samples_add(&stats.jitter, jitter_us < 0 ? -jitter_us : jitter_us);
+    }
+    stats.last_ns = now;
+
+    int cells = frame->width * frame->height;
+    const char* pacman = memchr(frame->data, 'C', cells);
+    int pos = pacman ? (int)(pacman - frame->data) : -1;
+
+    // Novo comando desde a frame anterior: a base é a posição nessa frame (ou
+    // nesta, se for a primeira)
+    long long sent = atomic_load(&command_sent_ns);
+    if (sent != stats.command_ns) {
+        if (stats.echo_waiting) stats.no_echo++;
+        stats.command_ns = sent;
+        stats.echo_waiting = true;
+        stats.echo_from = stats.frames == 1 ? pos : stats.pacman_pos;
+    }
+    if (stats.echo_waiting && pos != stats.echo_from) {
+        samples_add(&stats.echo, (long)((now - stats.command_ns) / 1000));
+        stats.echo_waiting = false;
+    }
+    stats.pacman_pos = pos;
+}
+
+static int compare_long(const void* a, const void* b) {
+    long x = *(const long*)a, y = *(const long*)b;
+    return (x > y) - (x < y);
+}
+
+static void print_percentiles(const char* name, samples_t* s) {
+    if (s->len == 0) {
+        printf("%-28s sem amostras\n", name);
+        return;
+    }
+    qsort(s->values, s->len, sizeof(long), compare_long);
+    double p[] = {0.50, 0.90, 0.99};
+    printf("%-28s", name);
+    for (int i = 0; i < 3; i++) {
+        printf(" p%-2d %8.3f", (int)(p[i] * 100), s->values[(int)(p[i] * (s->len - 1))] / 1000.0);
+    }
+    printf("  máx %8.3f ms (%d amostras)\n", s->values[s->len - 1] / 1000.0, s->len);
+}
+
+static void print_stats(void) {
+    double secs = stats.frames > 1 ? (stats.last_ns - stats.first_ns) / 1e9 : 0;
+    printf("frames recebidas: %ld em %.3f s (%.1f frames/s)\n",
+           stats.frames, secs, secs > 0 ? (stats.frames - 1) / secs : 0.0);
+    print_percentiles("intervalo entre frames:", &stats.intervals);
+    print_percentiles("jitter (|intervalo-tempo|):", &stats.jitter);
+    print_percentiles("entrada -> eco:", &stats.echo);
+    printf("comandos sem eco: %ld\n", stats.no_echo);
+}
 
-        pthread_mutex_lock(&mutex);
+// Guião completo em memória: só os comandos, sem mudanças de linha. Um 'Q'
+// termina o guião (*quit); sem 'Q' repete-se até ao fim do jogo.
+static char* load_script(FILE* fp, int* len, bool* quit) {
+    int cap = 64;
+    char* script = malloc(cap);
+    *len = 0;
+    *quit = false;
 
-        // Sem atualização (pipe não tinha dados agora) -> continuar a aguardar
-        if (!new_board.data && new_board.game_over == 0) {
-            pthread_mutex_unlock(&mutex);
-            sleep_ms(10); // evitar ciclo apertado (~10 ms)
+    int ch;
+    while (script && (ch = fgetc(fp)) != EOF) {
+        char command = (char)toupper(ch);
+        if (command == '\n' || command == '\r' || command == '\0')
             continue;
+        if (command == 'Q') {
+            *quit = true;
+            break;
+        }
+        if (*len == cap) {
+            cap *= 2;
+            char* grown = realloc(script, cap);
+            if (!grown) {
+                free(script);
+                return NULL;
+            }
+            script = grown;
         }
+        script[(*len)++] = command;
+    }
+    return script;
+}
 
-        // Caso especial: EOF do pipe (game_over==1 mas sem board.data).
-        // Usamos o último tabuleiro conhecido e apenas marcamos GAME OVER.
-        if (!new_board.data && new_board.game_over == 1) {
-            board.game_over = 1;
-            draw_board_client(board);
-            refresh_screen();
-            stop_execution = true;
-            pthread_mutex_unlock(&mutex);
+// SIGINT/SIGTERM: parar e mostrar as estatísticas na mesma
+static void stop_handler(int sig) {
+    (void)sig;
+    atomic_store(&stop_execution, true);
+    receive_board_cancel();
+}
+
+// Envia o guião um comando por tick, com prazos absolutos (sem deriva)
+static void run_script(FILE* cmd_fp) {
+    int len;
+    bool quit;
+    char* script = load_script(cmd_fp, &len, &quit);
+    if (!script) {
+        fprintf(stderr, "Erro de alocação de memória\n");
+        return;
+    }
+
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    for (long i = 0; !atomic_load(&stop_execution); i++) {
+        if (len == 0 || (quit && i == len)) {
+            debug("Commands file finished\n");
             break;
         }
 
-        // Atualizar variáveis globais (inclui casos de vitória e game over)
-        if (board.data && board.data != new_board.data) {
-            free(board.data);
+        atomic_store(&command_sent_ns, now_ns());
+        pacman_play(script[i % len]);
+
+        long long period_ns = atomic_load(&tempo) * 1000000LL;
+        next.tv_nsec += period_ns % 1000000000LL;
+        next.tv_sec += period_ns / 1000000000LL + next.tv_nsec / 1000000000L;
+        next.tv_nsec %= 1000000000L;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR &&
+               !atomic_load(&stop_execution)) {
         }
-        board = new_board;
-        tempo = board.tempo;
+    }
 
-        // Desenhar tabuleiro com o estado mais recente
-        // (se board.game_over == 1, draw_board_client mostra "GAME OVER")
-        draw_board_client(board);
-        refresh_screen();
+    free(script);
+}
 
-        // Se o jogo terminou (game_over == 1), sinalizar paragem e sair do ciclo
-        if (board.game_over == 1) {
-            stop_execution = true;
-            pthread_mutex_unlock(&mutex);
+// ==================== THREADS ====================
+
+static void* receiver_thread(void* arg) {
+    (void)arg;
+    int back = 0;
+
+    while (!atomic_load(&stop_execution)) {
+        // Bloqueia até chegar uma frame completa (ou receive_board_cancel).
+        // A frame é descodificada diretamente no slot do recetor.
+        Board* frame = &frames.slots[back];
+        int result = receive_board_into(frame, -1);
+
+        // Sem atualização (espera cancelada) -> voltar a ver stop_execution
+        if (result == RECEIVE_NONE) {
+            continue;
+        }
+
+        // Caso especial: EOF do pipe (servidor fechou a sessão sem frame).
+        // A thread de desenho usa o último tabuleiro e marca GAME OVER.
+        if (result == RECEIVE_CLOSED) {
+            atomic_store(&game_closed, true);
+            request_stop();
             break;
         }
 
-        pthread_mutex_unlock(&mutex);
+        atomic_store(&tempo, frame->tempo);
+        bool game_over = frame->game_over == 1;
+        if (headless) {
+            stats_frame(frame);     // o slot é logo reaproveitado
+        } else {
+            frame_publish(&back);
+        }
+
+        // Se o jogo terminou (game_over == 1), sinalizar paragem e sair do ciclo
+        if (game_over) {
+            request_stop();
+            break;
+        }
     }
 
     debug("Receiver thread ending...\n");
     return NULL;
 }
 
+// Desenha sempre a frame mais recente; o terminal pode ser lento sem atrasar
+// nem a receção nem o envio de comandos
+static void* render_thread(void* arg) {
+    (void)arg;
+    int front = 2;
+
+    while (true) {
+        while (sem_wait(&frames.ready) == -1 && errno == EINTR) {
+        }
+
+        bool fresh = frame_take(&front);
+        bool closed = atomic_load(&game_closed);
+        if (fresh || closed) {
+            // (se board.game_over == 1, draw_board_client mostra "GAME OVER")
+            Board board = frames.slots[front];
+            if (closed) board.game_over = 1;
+            draw_board_client(board);
+            refresh_screen();
+        }
+
+        // Sair só depois de desenhar a última frame publicada
+        if (atomic_load(&stop_execution) && !(atomic_load(&frames.middle) & FRAME_FRESH)) {
+            break;
+        }
+    }
+
+    debug("Render thread ending...\n");
+    return NULL;
+}
+
+// Comandos do teclado ou de um ficheiro, até alguém pedir para parar
+static void run_terminal(FILE* cmd_fp) {
+    char command;
+
+    // Verificar se deve parar (sem locks: o desenho nunca atrasa os comandos)
+    while (!atomic_load(&stop_execution)) {
+        if (cmd_fp) {
+            // Input from file: um lote por mensagem em vez de um write por comando
+            play_cmd_t batch[FILE_BATCH_SIZE];
+            bool quit = false;
+            int n = read_command_batch(cmd_fp, batch, FILE_BATCH_SIZE, &quit);
+
+            if (n > 0) {
+                debug("Sending batch of %d commands\n", n);
+                pacman_play_batch(batch, n);
+            }
+
+            if (quit) {
+                debug("Commands file asked to quit\n");
+                request_stop();
+                receive_board_cancel();
+                break;
+            }
+
+            // Esperar que o servidor jogue o lote (um tick por repetição)
+            int turns = 0;
+            for (int i = 0; i < n; i++) turns += batch[i].repeat;
+            if (turns == 0) turns = 1;
+
+            sleep_ms(atomic_load(&tempo) * turns);
+            continue;
+        }
+
+        // Interactive input
+        command = get_input();
+        command = toupper(command);
+
+        if (command == '\0')
+            continue;
+
+        if (command == 'Q') {
+            debug("Client pressed 'Q', quitting game\n");
+            request_stop();
+            receive_board_cancel();
+            break;
+        }
+
+        debug("Sending command: %c\n", command);
+
+        pacman_play(command);
+    }
+}
+
 int main(int argc, char* argv[]) {
-    if (argc != 3 && argc != 4) {
+    // -t shm: pedir ao servidor os tabuleiros por memória partilhada
+    // -u: register_pipe é o socket Unix do servidor (Pacmanist -u)
+    // -H: sem ncurses; envia o ficheiro de comandos e mostra estatísticas
+    int transport = TRANSPORT_PIPE;
+    bool use_socket = false;
+    bool bad_usage = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "t:uH")) != -1) {
+        if (opt == 'u') {
+            use_socket = true;
+        } else if (opt == 'H') {
+            headless = true;
+        } else if (opt == 't' && strcmp(optarg, "shm") == 0) {
+            transport = TRANSPORT_SHM;
+        } else if (opt != 't' || strcmp(optarg, "pipe") != 0) {
+            bad_usage = true;
+        }
+    }
+
+    int n_args = argc - optind;
+    if (bad_usage || (n_args != 2 && n_args != 3) || (headless && n_args != 3)) {
         fprintf(stderr,
-            "Usage: %s <client_id> <register_pipe> [commands_file]\n",
-            argv[0]);
+            "Usage: %s [-t pipe|shm] [-u] <client_id> <register_pipe|socket> [commands_file]\n"
+            "       %s -H [-t pipe|shm] [-u] <client_id> <register_pipe|socket> <commands_file>\n",
+            argv[0], argv[0]);
         return 1;
     }
 
-    const char* client_id = argv[1];
-    const char* register_pipe_name = argv[2];
-    const char* commands_file = (argc == 4) ? argv[3] : NULL;
+    const char* client_id = argv[optind];
+    const char* register_pipe_name = argv[optind + 1];
+    const char* commands_file = (n_args == 3) ? argv[optind + 2] : NULL;
 
     FILE* cmd_fp = NULL;
     if (commands_file) {
@@ -123,7 +467,12 @@ int main(int argc, char* argv[]) {
 
     debug("Connecting to server...\n");
 
-    int conn_res = pacman_connect(req_pipe_path, notif_pipe_path, register_pipe_path);
+    int conn_res;
+    if (use_socket) {
+        conn_res = pacman_connect_unix(register_pipe_name, atoi(client_id), transport);
+    } else {
+        conn_res = pacman_connect_ex(req_pipe_path, notif_pipe_path, register_pipe_path, transport);
+    }
 
     if (conn_res != 0) {
         debug("Failed to connect to server\n");
@@ -132,86 +481,58 @@ int main(int argc, char* argv[]) {
     }
 
     // Criar thread para receber atualizações
+    sem_init(&frames.ready, 0, 0);
     pthread_t receiver_thread_id;
     pthread_create(&receiver_thread_id, NULL, receiver_thread, NULL);
 
-    // Inicializar terminal ncurses
-    terminal_init();
-    set_timeout(500);
-    
-    refresh_screen();
-
-    char command;
-    int ch;
-
-    while (1) {
-        // Verificar se deve parar
-        pthread_mutex_lock(&mutex);
-        if (stop_execution) {
-            pthread_mutex_unlock(&mutex);
-            break;
-        }
-        pthread_mutex_unlock(&mutex);
-
-        if (cmd_fp) {
-            // Input from file
-            ch = fgetc(cmd_fp);
-
-            if (ch == EOF) {
-                // Reiniciar ficheiro
-                rewind(cmd_fp);
-                continue;
-            }
-
-            command = (char)ch;
-
-            if (command == '\n' || command == '\r' || command == '\0')
-                continue;
-
-            command = toupper(command);
-
-            // Esperar pelo tempo do jogo
-            pthread_mutex_lock(&mutex);
-            int wait_for = tempo;
-            pthread_mutex_unlock(&mutex);
-
-            sleep_ms(wait_for);
-
-        }
-        else {
-            // Interactive input
-            command = get_input();
-            command = toupper(command);
-        }
-
-        if (command == '\0')
-            continue;
+    pthread_t render_thread_id;
+    if (headless) {
+        // Sem SIGPIPE (o servidor pode fechar primeiro) e com Ctrl+C a mostrar
+        // as estatísticas
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = stop_handler;
+        sigaction(SIGINT, &sa, NULL);
+        sigaction(SIGTERM, &sa, NULL);
+        signal(SIGPIPE, SIG_IGN);
+
+        run_script(cmd_fp);
+    } else {
+        // Inicializar terminal ncurses
+        terminal_init();
+        set_timeout(500);
 
-        if (command == 'Q') {
-            debug("Client pressed 'Q', quitting game\n");
-            pthread_mutex_lock(&mutex);
-            stop_execution = true;
-            pthread_mutex_unlock(&mutex);
-            break;
-        }
+        refresh_screen();
 
-        debug("Sending command: %c\n", command);
+        // Só depois do ncurses iniciado: a thread de desenho é a única a
+        // escrever no ecrã
+        pthread_create(&render_thread_id, NULL, render_thread, NULL);
 
-        pacman_play(command);
+        run_terminal(cmd_fp);
     }
 
-    // Aguardar thread de receção
+    // Fim do guião: a receção também pára (se ainda não parou)
+    request_stop();
+    receive_board_cancel();
+
+    // Aguardar threads de receção e de desenho
     pthread_join(receiver_thread_id, NULL);
+    if (!headless) pthread_join(render_thread_id, NULL);
 
     debug("Disconnecting...\n");
+    for (int i = 0; i < 3; i++) release_board(&frames.slots[i]);
     pacman_disconnect();
 
     if (cmd_fp)
         fclose(cmd_fp);
 
-    pthread_mutex_destroy(&mutex);
+    sem_destroy(&frames.ready);
 
-    terminal_cleanup();
+    if (headless) {
+        print_stats();
+    } else {
+        terminal_cleanup();
+    }
 
     close_debug_file();
 
@@ -11,7 +11,9 @@ void open_debug_file(char *filename) {
 }
 
 void close_debug_file() {
+    if (!debugfile) return;
     fclose(debugfile);
+    debugfile = NULL;   // debug() depois disto não faz nada
 }
 
 void debug(const char * format, ...) {
@@ -30,4 +32,26 @@ void sleep_ms(int milliseconds) {
     ts.tv_sec = milliseconds / 1000;
     ts.tv_nsec = (milliseconds % 1000) * 1000000;
     nanosleep(&ts, NULL);
-}
\ No newline at end of file
+}
+void timespec_add_ms(struct timespec* ts, int milliseconds) {
+    ts->tv_sec += milliseconds / 1000;
+    ts->tv_nsec += (long)(milliseconds % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+int timespec_cmp(const struct timespec* a, const struct timespec* b) {
+    if (a->tv_sec != b->tv_sec) return a->tv_sec < b->tv_sec ? -1 : 1;
+    if (a->tv_nsec != b->tv_nsec) return a->tv_nsec < b->tv_nsec ? -1 : 1;
+    return 0;
+}
+
+long timespec_diff_ms(const struct timespec* a, const struct timespec* b) {
+    return (a->tv_sec - b->tv_sec) * 1000L + (a->tv_nsec - b->tv_nsec) / 1000000L;
+}
+
+long timespec_diff_us(const struct timespec* a, const struct timespec* b) {
+    return (a->tv_sec - b->tv_sec) * 1000000L + (a->tv_nsec - b->tv_nsec) / 1000L;
+}
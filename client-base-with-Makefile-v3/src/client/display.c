@@ -2,13 +2,17 @@
 #include "board.h"
 #include "api.h"
 #include <stdlib.h>
+#include <string.h>
 #include <ctype.h>
 
 
-int terminal_init() {
-    // Initialize ncurses mode
-    initscr();
+// Keys are read from this window, which is never drawn on: getch() on stdscr
+// would first refresh it, so reading input would wait for (and race with) the
+// thread drawing the board
+static WINDOW* input_win = NULL;
 
+// Settings shared by terminal_init and terminal_init_file
+static void terminal_setup() {
     // Disable line buffering - get characters immediately
     cbreak();
 
@@ -20,6 +24,13 @@ int terminal_init() {
 
     timeout(1000);
 
+    input_win = newwin(1, 1, 0, 0);
+    if (input_win) {
+        keypad(input_win, TRUE);
+        wtimeout(input_win, 1000);
+        untouchwin(input_win);  // new windows count as changed: never paint it
+    }
+
     // Make getch() non-blocking (return ERR if no input)
     // nodelay(stdscr, TRUE); // Uncomment if non-blocking input is desired
 
@@ -42,109 +53,155 @@ int terminal_init() {
 
     // Clear the screen
     clear();
+}
+
+int terminal_init() {
+    // Initialize ncurses mode
+    initscr();
+    terminal_setup();
+    return 0;
+}
 
+int terminal_init_file(FILE* out, FILE* in, const char* term) {
+    SCREEN* screen = newterm(term, out, in);
+    if (!screen) return -1;
+    set_term(screen);
+    terminal_setup();
     return 0;
 }
 
 
+// Last frame drawn by draw_board_client: only what changed since then is
+// sent to ncurses (and from there to the terminal)
+#define CLIENT_BOARD_ROW 3
+
+enum { CLIENT_PLAYING, CLIENT_GAME_OVER, CLIENT_VICTORY };
+
+static struct {
+    int valid;      // 0: the next frame is drawn from scratch
+    int width;
+    int height;
+    int state;
+    int points;
+    char* cells;
+} shown = {0};
+
+void draw_board_client_invalidate() {
+    shown.valid = 0;
+}
+
+// Character and attributes of one board cell
+static chtype client_cell(char ch) {
+    switch (ch) {
+        case '#': // Wall
+            return '#' | COLOR_PAIR(3);
+        case 'C': // Pacman
+            return 'C' | COLOR_PAIR(1) | A_BOLD;
+        case 'M': // Monster/Ghost
+            return 'M' | COLOR_PAIR(2) | A_BOLD;
+        case 'G': // Charged Monster/Ghost
+            return 'M' | COLOR_PAIR(2) | A_BOLD | A_DIM;
+        case '.': // Dot
+            return '.' | COLOR_PAIR(4);
+        case '@': // Portal
+            return '@' | COLOR_PAIR(6);
+        default:
+            return (unsigned char)ch;
+    }
+}
+
 void draw_board_client(Board board) {
-    // Clear the screen before redrawing
-    clear();
-    
     // Verificar se board tem dados válidos
     if (!board.data || board.width == 0 || board.height == 0) {
+        clear();
         mvprintw(0, 0, "Waiting for game data...");
         refresh();
+        shown.valid = 0;
         return;
     }
 
-    // Draw the border/title
-    attron(COLOR_PAIR(5));
-    mvprintw(0, 0, "=== PACMAN GAME ===");
-    if (board.game_over) {
-        mvprintw(1, 0, " GAME OVER ");
-    } else if (board.victory) {
-        mvprintw(1, 0, " VICTORY ");
-    } else {
-        mvprintw(1, 0, " Use W/A/S/D to move | Q to quit");
+    int cells = board.width * board.height;
+    int full = !shown.valid || board.width != shown.width || board.height != shown.height;
+    if (full) {
+        // New board (or size): start from a blank screen
+        if (cells != shown.width * shown.height || !shown.cells) {
+            char* grown = realloc(shown.cells, cells);
+            if (!grown) {
+                free(shown.cells);
+                shown.width = shown.height = 0;
+            }
+            shown.cells = grown;
+        }
+        clear();
+        attron(COLOR_PAIR(5));
+        mvprintw(0, 0, "=== PACMAN GAME ===");
+        attroff(COLOR_PAIR(5));
     }
 
-    // Starting row for the game board (leave space for UI)
-    int start_row = 3;
+    // Status line only when the state changes
+    int state = board.game_over ? CLIENT_GAME_OVER : board.victory ? CLIENT_VICTORY : CLIENT_PLAYING;
+    if (full || state != shown.state) {
+        move(1, 0);
+        clrtoeol();
+        attron(COLOR_PAIR(5));
+        if (state == CLIENT_GAME_OVER) {
+            mvprintw(1, 0, " GAME OVER ");
+        } else if (state == CLIENT_VICTORY) {
+            mvprintw(1, 0, " VICTORY ");
+        } else {
+            mvprintw(1, 0, " Use W/A/S/D to move | Q to quit");
+        }
+        attroff(COLOR_PAIR(5));
+    }
 
-    // Draw the board
+    // Only the cells that differ from the last frame
     for (int y = 0; y < board.height; y++) {
         for (int x = 0; x < board.width; x++) {
-            char ch = board.data[y * board.width + x];
-
-            // Move cursor to position
-            move(start_row + y, x);
-
-            // Draw with appropriate color
-            switch (ch) {
-                case '#': // Wall
-                    attron(COLOR_PAIR(3));
-                    addch('#');
-                    attroff(COLOR_PAIR(3));
-                    break;
-
-                case 'C': // Pacman
-                    attron(COLOR_PAIR(1) | A_BOLD);
-                    addch('C');
-                    attroff(COLOR_PAIR(1) | A_BOLD);
-                    break;
-
-                case 'M': // Monster/Ghost
-                    attron(COLOR_PAIR(2) | A_BOLD);
-                    addch('M');
-                    attroff(COLOR_PAIR(2) | A_BOLD);  
-                    break;
-
-                case 'G': // Charged Monster/Ghost
-                    attron((COLOR_PAIR(2) | A_BOLD) | A_DIM);
-                    addch('M');
-                    attroff((COLOR_PAIR(2) | A_BOLD) | A_DIM);  
-                    break;
-
-                case '.': // Dot
-                    attron(COLOR_PAIR(4));
-                    addch('.');
-                    attroff(COLOR_PAIR(4));
-                    break;
-
-                case '@': // Portal
-                    attron(COLOR_PAIR(6));
-                    addch('@');
-                    attroff(COLOR_PAIR(6));
-                    break;
-
-                case ' ': // Empty space
-                    addch(' ');
-                    break;
-
-                default:
-                    addch(ch);
-                    break;
+            int index = y * board.width + x;
+            char ch = board.data[index];
+            if (full || ch != shown.cells[index]) {
+                mvaddch(CLIENT_BOARD_ROW + y, x, client_cell(ch));
             }
         }
     }
 
-    // Draw score/status at the bottom
-    attron(COLOR_PAIR(5));
-    mvprintw(start_row + board.height + 1, 0, "Points: %d",
-             board.accumulated_points);
-    attroff(COLOR_PAIR(5));
+    // Draw score/status at the bottom (only when the points change)
+    if (full || board.accumulated_points != shown.points) {
+        int row = CLIENT_BOARD_ROW + board.height + 1;
+        move(row, 0);
+        clrtoeol();
+        attron(COLOR_PAIR(5));
+        mvprintw(row, 0, "Points: %d", board.accumulated_points);
+        attroff(COLOR_PAIR(5));
+    }
+
+    // Without memory for the copy, every frame is drawn from scratch
+    shown.valid = shown.cells != NULL;
+    if (shown.valid) {
+        memcpy(shown.cells, board.data, cells);
+        shown.width = board.width;
+        shown.height = board.height;
+        shown.state = state;
+        shown.points = board.accumulated_points;
+    }
 }
 
 // Does exaclty the same as draw board but stores the output in a string instead of printing it
 char* get_board_displayed(board_t* board) {
     size_t buffer_size = (board->width  * board->height) + 1;
     char* output = malloc(buffer_size);
+    if (!output) return NULL;
+    fill_board_displayed(board, output);
+    output[buffer_size - 1] = '\0';
+    return output;
+}
+
+void fill_board_displayed(board_t* board, char* output) {
     size_t pos = 0;
     for (int y = 0; y < board->height; y++) {
         for (int x = 0; x < board->width; x++) {
             int index = y * board->width + x;
-            char ch = board->board[index].content;
+            char ch = board_content(board, index);
             int ghost_charged = 0;
 
             for (int g = 0; g < board->n_ghosts; g++) {
@@ -175,10 +232,10 @@ char* get_board_displayed(board_t* board) {
                     break;
 
                 case ' ': // Empty space
-                    if (board->board[index].has_portal) {
+                    if (board_has_portal(board, index)) {
                         output[pos++] = '@';
                     }
-                    else if (board->board[index].has_dot) {
+                    else if (board_has_dot(board, index)) {
                         output[pos++] = '.';
                     }
                     else
@@ -191,9 +248,6 @@ char* get_board_displayed(board_t* board) {
             }
         }
     }
-    
-    output[pos] = '\0';
-    return output;
 }
 
 void draw_board(board_t* board, int mode) {
@@ -225,7 +279,7 @@ void draw_board(board_t* board, int mode) {
     for (int y = 0; y < board->height; y++) {
         for (int x = 0; x < board->width; x++) {
             int index = y * board->width + x;
-            char ch = board->board[index].content;
+            char ch = board_content(board, index);
             int ghost_charged = 0;
 
             for (int g = 0; g < board->n_ghosts; g++) {
@@ -261,12 +315,12 @@ void draw_board(board_t* board, int mode) {
                     break;
 
                 case ' ': // Empty space
-                    if (board->board[index].has_portal) {
+                    if (board_has_portal(board, index)) {
                         attron(COLOR_PAIR(6));
                         addch('@');
                         attroff(COLOR_PAIR(6));
                     }
-                    else if (board->board[index].has_dot) {
+                    else if (board_has_dot(board, index)) {
                         attron(COLOR_PAIR(4));
                         addch('.');
                         attroff(COLOR_PAIR(4));
@@ -303,7 +357,7 @@ void refresh_screen() {
 
 char get_input() {
     // Get a character from the keyboard
-    int ch = getch();
+    int ch = input_win ? wgetch(input_win) : getch();
 
     // getch() returns ERR if no input is available
     if (ch == ERR) {
@@ -329,9 +383,12 @@ char get_input() {
 
 void terminal_cleanup() {
     // Restore terminal settings and clean up ncurses
+    if (input_win) delwin(input_win);
+    input_win = NULL;
     endwin();
 }
 
 void set_timeout(int timeout_ms) {
     timeout(timeout_ms);
+    if (input_win) wtimeout(input_win, timeout_ms);
 }
\ No newline at end of file
@@ -0,0 +1,208 @@
+#include "engine.h"
+#include "debug.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+
+// Número máximo de eventos retirados do heap por cada acordar de uma thread
+#define ENGINE_BATCH 32
+
+// ==================== ESTADO DO MOTOR ====================
+
+// Min-heap de eventos ordenado pelo prazo absoluto
+static engine_event_t* heap = NULL;
+static int heap_len = 0;
+static int heap_cap = 0;
+static int heap_reserved = 0;      // lugares prometidos a eventos (<= heap_cap)
+static pthread_mutex_t heap_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t heap_cond;
+static pthread_t* engine_tids = NULL;
+static int n_engine_threads = 0;
+
+// ==================== MIN-HEAP ====================
+// Todas as funções devem ser chamadas com heap_mutex
+
+static void heap_swap(int a, int b) {
+    engine_event_t tmp = heap[a];
+    heap[a] = heap[b];
+    heap[b] = tmp;
+}
+
+// Garante lugar para mais n eventos (-1 se não há memória)
+static int heap_reserve(int n) {
+    if (heap_reserved + n > heap_cap) {
+        int new_cap = heap_cap ? heap_cap * 2 : 64;
+        while (new_cap < heap_reserved + n) new_cap *= 2;
+        engine_event_t* grown = realloc(heap, new_cap * sizeof(engine_event_t));
+        if (!grown) return -1;
+        heap = grown;
+        heap_cap = new_cap;
+    }
+    heap_reserved += n;
+    return 0;
+}
+
+// Devolve 1 se o evento ficou à cabeça do heap. Nunca aloca: cada evento
+// vivo tem um lugar reservado (heap_len <= heap_reserved <= heap_cap)
+static int heap_push(const engine_event_t* ev) {
+    if (heap_len == heap_cap) {
+        fprintf(stderr, "Evento do motor agendado sem lugar reservado: descartado\n");
+        return 0;
+    }
+
+    int i = heap_len++;
+    heap[i] = *ev;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (timespec_cmp(&heap[parent].due, &heap[i].due) <= 0) break;
+        heap_swap(parent, i);
+        i = parent;
+    }
+    return i == 0;
+}
+
+static engine_event_t heap_pop(void) {
+    engine_event_t top = heap[0];
+    heap[0] = heap[--heap_len];
+
+    int i = 0;
+    while (1) {
+        int left = 2 * i + 1;
+        int right = left + 1;
+        int smallest = i;
+        if (left < heap_len && timespec_cmp(&heap[left].due, &heap[smallest].due) < 0) {
+            smallest = left;
+        }
+        if (right < heap_len && timespec_cmp(&heap[right].due, &heap[smallest].due) < 0) {
+            smallest = right;
+        }
+        if (smallest == i) break;
+        heap_swap(i, smallest);
+        i = smallest;
+    }
+    return top;
+}
+
+// ==================== THREADS DO MOTOR ====================
+
+static void* engine_thread(void* arg) {
+    (void)arg;
+
+    // Bloquear SIGUSR1 (apenas thread anfitriã recebe)
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+    engine_event_t batch[ENGINE_BATCH];
+    int keep[ENGINE_BATCH];
+
+    pthread_mutex_lock(&heap_mutex);
+    while (1) {
+        if (heap_len == 0) {
+            pthread_cond_wait(&heap_cond, &heap_mutex);
+            continue;
+        }
+
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (timespec_cmp(&heap[0].due, &now) > 0) {
+            // Dormir até ao prazo mais próximo (ou até chegar um mais urgente)
+            pthread_cond_timedwait(&heap_cond, &heap_mutex, &heap[0].due);
+            continue;
+        }
+
+        // Retirar de uma vez todos os eventos já vencidos (até ENGINE_BATCH)
+        int n = 0;
+        while (n < ENGINE_BATCH && heap_len > 0 && timespec_cmp(&heap[0].due, &now) <= 0) {
+            batch[n++] = heap_pop();
+        }
+
+        // Ainda há trabalho vencido: acordar outra thread do motor
+        if (heap_len > 0 && timespec_cmp(&heap[0].due, &now) <= 0) {
+            pthread_cond_signal(&heap_cond);
+        }
+        pthread_mutex_unlock(&heap_mutex);
+
+        for (int i = 0; i < n; i++) {
+            keep[i] = batch[i].task->run(batch[i].task, &batch[i]);
+        }
+
+        // Um evento reagendado volta ao seu lugar; um descartado liberta-o
+        pthread_mutex_lock(&heap_mutex);
+        for (int i = 0; i < n; i++) {
+            if (keep[i]) heap_push(&batch[i]);
+            else heap_reserved--;
+        }
+    }
+
+    pthread_mutex_unlock(&heap_mutex);
+    return NULL;
+}
+
+// ==================== API ====================
+
+int engine_init(int n_threads) {
+    if (n_threads <= 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        n_threads = cores > 0 ? (int)cores : 1;
+    }
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&heap_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    engine_tids = malloc(n_threads * sizeof(pthread_t));
+    if (!engine_tids) return -1;
+
+    for (int i = 0; i < n_threads; i++) {
+        if (pthread_create(&engine_tids[i], NULL, engine_thread, NULL) != 0) {
+            perror("Erro ao criar thread do motor");
+            return -1;
+        }
+        n_engine_threads++;
+    }
+
+    return 0;
+}
+
+int engine_threads(void) {
+    return n_engine_threads;
+}
+
+int engine_reserve(int n_events) {
+    pthread_mutex_lock(&heap_mutex);
+    int rc = heap_reserve(n_events);
+    pthread_mutex_unlock(&heap_mutex);
+    if (rc < 0) perror("Erro ao aumentar o heap do motor");
+    return rc;
+}
+
+void engine_schedule(engine_task_t* task, int kind, int index, unsigned gen,
+                     const struct timespec* due) {
+    engine_event_t ev;
+    ev.due = *due;
+    ev.task = task;
+    ev.kind = kind;
+    ev.index = index;
+    ev.gen = gen;
+
+    pthread_mutex_lock(&heap_mutex);
+    if (heap_push(&ev)) {
+        pthread_cond_signal(&heap_cond);
+    }
+    pthread_mutex_unlock(&heap_mutex);
+}
+
+void engine_next_deadline(struct timespec* due, int period_ms, const struct timespec* now) {
+    timespec_add_ms(due, period_ms);
+    if (timespec_diff_ms(now, due) > period_ms) {
+        *due = *now;
+        timespec_add_ms(due, period_ms);
+    }
+}
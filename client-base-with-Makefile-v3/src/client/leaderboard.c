@@ -0,0 +1,125 @@
+#include "leaderboard.h"
+#include <stdlib.h>
+#include <pthread.h>
+
+// ==================== ESTADO ====================
+
+// order[0..count) tem os slots por pontuação decrescente; pos[slot] é a
+// posição do slot em order (-1 se não estiver na classificação). Em caso de
+// empate fica à frente quem lá chegou primeiro.
+static int* order = NULL;
+static int* pos = NULL;
+static leaderboard_entry_t* entries = NULL;
+static int count = 0;
+static int capacity = 0;
+static pthread_mutex_t lb_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// ==================== REORDENAÇÃO ====================
+// Chamar com lb_mutex. Uma pontuação muda normalmente pouco de cada vez, por
+// isso a entrada só anda algumas posições.
+
+static void place(int slot, int p) {
+    order[p] = slot;
+    pos[slot] = p;
+}
+
+// Sobe a entrada enquanto tiver mais pontos do que a anterior
+static void move_up(int slot) {
+    int p = pos[slot];
+    int points = entries[slot].points;
+    while (p > 0 && entries[order[p - 1]].points < points) {
+        place(order[p - 1], p);
+        p--;
+    }
+    place(slot, p);
+}
+
+// Desce a entrada enquanto tiver menos pontos do que a seguinte
+static void move_down(int slot) {
+    int p = pos[slot];
+    int points = entries[slot].points;
+    while (p < count - 1 && entries[order[p + 1]].points > points) {
+        place(order[p + 1], p);
+        p++;
+    }
+    place(slot, p);
+}
+
+// ==================== API ====================
+
+int leaderboard_init(int n) {
+    order = malloc(n * sizeof(int));
+    pos = malloc(n * sizeof(int));
+    entries = malloc(n * sizeof(leaderboard_entry_t));
+    if (!order || !pos || !entries) {
+        leaderboard_destroy();
+        return -1;
+    }
+
+    for (int i = 0; i < n; i++) pos[i] = -1;
+    capacity = n;
+    count = 0;
+    return 0;
+}
+
+void leaderboard_destroy(void) {
+    free(order);
+    free(pos);
+    free(entries);
+    order = pos = NULL;
+    entries = NULL;
+    count = capacity = 0;
+}
+
+void leaderboard_add(int slot, int client_id, int points) {
+    if (slot < 0 || slot >= capacity) return;
+
+    pthread_mutex_lock(&lb_mutex);
+    if (pos[slot] == -1) {
+        entries[slot].client_id = client_id;
+        entries[slot].points = points;
+        place(slot, count++);
+        move_up(slot);
+    }
+    pthread_mutex_unlock(&lb_mutex);
+}
+
+void leaderboard_remove(int slot) {
+    if (slot < 0 || slot >= capacity) return;
+
+    pthread_mutex_lock(&lb_mutex);
+    int p = pos[slot];
+    if (p != -1) {
+        // Fechar o buraco mantendo a ordem das restantes
+        for (int i = p + 1; i < count; i++) {
+            place(order[i], i - 1);
+        }
+        count--;
+        pos[slot] = -1;
+    }
+    pthread_mutex_unlock(&lb_mutex);
+}
+
+void leaderboard_update(int slot, int points) {
+    if (slot < 0 || slot >= capacity) return;
+
+    pthread_mutex_lock(&lb_mutex);
+    if (pos[slot] != -1) {
+        int old = entries[slot].points;
+        entries[slot].points = points;
+        if (points > old) move_up(slot);
+        else if (points < old) move_down(slot);
+    }
+    pthread_mutex_unlock(&lb_mutex);
+}
+
+int leaderboard_top(leaderboard_entry_t* out, int k, int* active) {
+    pthread_mutex_lock(&lb_mutex);
+    int n = k < count ? k : count;
+    for (int i = 0; i < n; i++) {
+        out[i] = entries[order[i]];
+    }
+    if (active) *active = count;
+    pthread_mutex_unlock(&lb_mutex);
+    return n;
+}
@@ -0,0 +1,115 @@
+#include "level_cache.h"
+#include "board.h"
+#include "parser.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+
+typedef struct {
+    char filename[MAX_FILENAME];    // chave: nome do ficheiro .lvl
+    board_t level;                  // nível compilado (sem locks inicializados)
+} cached_level_t;
+
+static cached_level_t* levels = NULL;
+static int n_levels = 0;
+static char cache_dir[MAX_FILENAME];
+
+// Liberta um nível compilado (não tem locks para destruir)
+static void free_level(board_t* level) {
+    board_free_cells(level);
+    free(level->display);
+    free(level->pacmans);
+    free(level->ghosts);
+}
+
+// Compila um nível a partir do disco (como o load_level fazia a cada sessão)
+static int compile_level(board_t* level, char* filename, char* dirname) {
+    memset(level, 0, sizeof(board_t));
+
+    if (read_level(level, filename, dirname) < 0) {
+        return -1;
+    }
+    read_pacman(level, 0);
+    read_ghosts(level);
+    if (board_display_rebuild(level) < 0) {
+        free_level(level);
+        return -1;
+    }
+    return 0;
+}
+
+int level_cache_build(char* dirname) {
+    DIR* dir = opendir(dirname);
+    if (!dir) {
+        return -1;
+    }
+
+    snprintf(cache_dir, sizeof(cache_dir), "%s", dirname);
+
+    int capacity = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+
+        char* dot = strrchr(entry->d_name, '.');
+        if (!dot || strcmp(dot, ".lvl") != 0) continue;
+
+        if (n_levels == capacity) {
+            int new_capacity = capacity ? capacity * 2 : 16;
+            cached_level_t* grown = realloc(levels, new_capacity * sizeof(cached_level_t));
+            if (!grown) break;
+            levels = grown;
+            capacity = new_capacity;
+        }
+
+        cached_level_t* cached = &levels[n_levels];
+        snprintf(cached->filename, sizeof(cached->filename), "%s", entry->d_name);
+        if (compile_level(&cached->level, cached->filename, dirname) < 0) {
+            fprintf(stderr, "ERRO: não foi possível compilar o nível %s\n", entry->d_name);
+            continue;
+        }
+        n_levels++;
+    }
+    closedir(dir);
+
+    return n_levels;
+}
+
+int level_cache_count(void) {
+    return n_levels;
+}
+
+int level_cache_max_cells(void) {
+    int max_cells = 0;
+    for (int i = 0; i < n_levels; i++) {
+        int cells = levels[i].level.width * levels[i].level.height;
+        if (cells > max_cells) max_cells = cells;
+    }
+    return max_cells;
+}
+
+const board_t* level_cache_get(int index) {
+    if (index < 0 || index >= n_levels) return NULL;
+    return &levels[index].level;
+}
+
+const board_t* level_cache_find(const char* dirname, const char* filename) {
+    if (n_levels == 0 || strcmp(dirname, cache_dir) != 0) return NULL;
+
+    for (int i = 0; i < n_levels; i++) {
+        if (strcmp(levels[i].filename, filename) == 0) {
+            return &levels[i].level;
+        }
+    }
+    return NULL;
+}
+
+void level_cache_destroy(void) {
+    for (int i = 0; i < n_levels; i++) {
+        free_level(&levels[i].level);
+    }
+    free(levels);
+    levels = NULL;
+    n_levels = 0;
+}
@@ -5,43 +5,131 @@
 #include "parser.h"
 #include "board.h"
 #include <fcntl.h>
+#include <sys/stat.h>
+
+// Whole file loaded in memory, handed out one line at a time
+typedef struct {
+    char* data;
+    char* cur;
+    char* end;
+} file_buf_t;
+
+// Loads the whole file with a single read (or a few, for very large files)
+static int file_buf_open(file_buf_t* fb, const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        return -1;
+    }
+
+    size_t size = (size_t)st.st_size;
+    fb->data = malloc(size + 1);
+    if (!fb->data) {
+        close(fd);
+        return -1;
+    }
+
+    size_t total = 0;
+    while (total < size) {
+        ssize_t n = read(fd, fb->data + total, size - total);
+        if (n == -1) {
+            free(fb->data);
+            close(fd);
+            return -1;
+        }
+        if (n == 0) break;
+        total += n;
+    }
+    close(fd);
+
+    fb->data[total] = '\0';
+    fb->cur = fb->data;
+    fb->end = fb->data + total;
+    return 0;
+}
+
+static void file_buf_close(file_buf_t* fb) {
+    free(fb->data);
+    fb->data = fb->cur = fb->end = NULL;
+}
+
+// Returns the next line (without '\n'/'\r', any length) or NULL at the end.
+// The line lives inside the file buffer until file_buf_close.
+static char* file_buf_next_line(file_buf_t* fb) {
+    if (fb->cur >= fb->end) return NULL;
+
+    char* line = fb->cur;
+    char* nl = memchr(line, '\n', fb->end - line);
+    if (nl) {
+        *nl = '\0';
+        fb->cur = nl + 1;
+    } else {
+        nl = fb->end;
+        fb->cur = fb->end;
+    }
+
+    if (nl > line && nl[-1] == '\r') nl[-1] = '\0';
+    return line;
+}
+
+// comment or empty line
+static int is_skippable(const char* line) {
+    return line[0] == '#' || line[0] == '\0';
+}
+
+// line with nothing but spaces/tabs
+static int is_blank(const char* line) {
+    return line[strspn(line, " \t")] == '\0';
+}
+
+// Checks if the line starts with the given keyword; *args points right after it.
+// The line is left untouched when it does not match (it may be a grid/move line).
+static int is_keyword(char* line, const char* keyword, char** args) {
+    line += strspn(line, " \t");
+    size_t len = strcspn(line, " \t");
+    if (len != strlen(keyword) || strncmp(line, keyword, len) != 0) {
+        return 0;
+    }
+    *args = line + len;
+    return 1;
+}
+
 int read_level(board_t* board, char* filename, char* dirname) {
 
     char fullname[MAX_FILENAME];
-    strcpy(fullname, dirname);
-    strcat(fullname, "/");
-    strcat(fullname, filename);
+    snprintf(fullname, sizeof(fullname), "%s/%s", dirname, filename);
 
-    int fd = open(fullname, O_RDONLY);
-    if (fd == -1) {
+    file_buf_t fb;
+    if (file_buf_open(&fb, fullname) == -1) {
         debug("Error opening file %s\n", fullname);
         return -1;
     }
-    
-    char command[MAX_COMMAND_LENGTH];
 
     // Pacman is optional
     board->pacman_file[0] = '\0';
     board->n_pacmans = 1;
+    board->n_dots = 0;
+    board->portal_reached = 0;
 
     strcpy(board->level_name, filename);
     *strrchr(board->level_name, '.') = '\0';
 
-    int read;
-    while (1) {
-
-        read = read_line(fd, command);
-        if (read <= 0) break;
+    char* line;
+    char* args;
+    char* save;
+    while ((line = file_buf_next_line(&fb)) != NULL) {
 
         // comment or blank line
-        if (command[0] == '#' || command[0] == '\0') continue;
+        if (is_skippable(line) || is_blank(line)) continue;
 
-        char *word = strtok(command, " \t\n");
-        if (!word) continue;  // skip empty line
-
-        if (strcmp(word, "DIM") == 0) {
-            char *arg1 = strtok(NULL, " \t\n");
-            char *arg2 = strtok(NULL, " \t\n");
+        if (is_keyword(line, "DIM", &args)) {
+            char *arg1 = strtok_r(args, " \t", &save);
+            char *arg2 = strtok_r(NULL, " \t", &save);
             if (arg1 && arg2) {
                 board->width = atoi(arg1);
                 board->height = atoi(arg2);
@@ -49,30 +137,31 @@ int read_level(board_t* board, char* filename, char* dirname) {
             }
         }
 
-        else if (strcmp(word, "TEMPO") == 0) {
-            char *arg = strtok(NULL, " \t\n");
+        else if (is_keyword(line, "TEMPO", &args)) {
+            char *arg = strtok_r(args, " \t", &save);
             if (arg) {
                 board->tempo = atoi(arg);
                 debug("TEMPO = %d\n", board->tempo);
             }
         }
 
-        else if (strcmp(word, "PAC") == 0) {
-            char *arg = strtok(NULL, " \t\n");
+        else if (is_keyword(line, "PAC", &args)) {
+            char *arg = strtok_r(args, " \t", &save);
             if (arg) {
                 snprintf(board->pacman_file, sizeof(board->pacman_file), "%s/%s", dirname, arg);
                 debug("PAC = %s\n", board->pacman_file);
             }
         }
 
-        else if (strcmp(word, "MON") == 0) {
-            char *arg;
+        else if (is_keyword(line, "MON", &args)) {
+            char *arg = strtok_r(args, " \t", &save);
             int i = 0;
-            while ((arg = strtok(NULL, " \t\n")) != NULL) {
+            while (arg != NULL) {
                 snprintf(board->ghosts_files[i], sizeof(board->ghosts_files[0]), "%s/%s", dirname, arg);
                 debug("MON file: %s\n", board->ghosts_files[i]);
                 i+= 1;
                 if (i == MAX_GHOSTS-1) break;
+                arg = strtok_r(NULL, " \t", &save);
             }
             board->n_ghosts = i;
         }
@@ -84,62 +173,84 @@ int read_level(board_t* board, char* filename, char* dirname) {
 
     if (!board->width || !board->height) {
         debug("Missing dimensions in level file\n");
-        close(fd);
+        file_buf_close(&fb);
         return -1;
     }
-    
+
     // the end of the file contains the grid
-    board->board = calloc(board->width * board->height, sizeof(board_pos_t));
+    if (board_alloc_cells(board) < 0) {
+        file_buf_close(&fb);
+        return -1;
+    }
     board->pacmans = calloc(board->n_pacmans, sizeof(pacman_t));
     board->ghosts = calloc(board->n_ghosts, sizeof(ghost_t));
 
     int row = 0;
-    // command here still holds the previous line
-    while (read > 0) {
-        if (command[0]== '#' || command[0] == '\0') continue;
+    // line here still holds the first line of the grid
+    for (; line != NULL; line = file_buf_next_line(&fb)) {
+        if (is_skippable(line)) continue;
         if (row >= board->height) break;
 
-        debug("Line: %s\n", command);
+        debug("Line: %s\n", line);
 
+        size_t len = strlen(line);
         for (int col = 0; col < board -> width; col++){
             int idx = row * board->width + col;
-            char content = command[col];
+            char content = (size_t)col < len ? line[col] : '\0';
 
             switch (content) {
                 case 'X': // wall
-                    board->board[idx].content = 'W';
+                    board_set_content(board, idx, 'W');
                     break;
                 case '@': // portal
-                    board->board[idx].content = ' ';
-                    board->board[idx].has_portal = 1;
+                    board_set_content(board, idx, ' ');
+                    board_set_portal(board, idx, 1);
                     break;
                 default:
-                    board->board[idx].content = ' ';
-                    board->board[idx].has_dot = 1;
+                    board_set_content(board, idx, ' ');
+                    board_set_dot(board, idx, 1);
+                    board->n_dots++;
                     break;
             }
         }
 
         row++;
-        read = read_line(fd, command);
     }
 
-    if (read == -1) {
-      debug("Failed parsing line");
-      close(fd);
-      return read;
-    }
-
-    close(fd);
+    board->dots_left = board->n_dots;
+    file_buf_close(&fb);
     return 0;
 }
 
+// Reads the move list that ends pacman/monster files (line holds the first move)
+static int read_moves(file_buf_t* fb, char* line, command_t* moves, const char* valid) {
+    int move = 0;
+    for (; line != NULL && move < MAX_MOVES; line = file_buf_next_line(fb)) {
+        if (is_skippable(line)) continue;
+        if (line[0] != '\0' && strchr(valid, line[0])) {
+            moves[move].command = line[0];
+            moves[move].turns = 1;
+            move += 1;
+        }
+        else if (line[0] == 'T' && line[1] == ' ') {
+            int t = atoi(line + 2);
+            if (t > 0) {
+                moves[move].command = line[0];
+                moves[move].turns = t;
+                moves[move].turns_left = t;
+                move += 1;
+            }
+        }
+    }
+    return move;
+}
+
 int read_pacman(board_t* board, int points) {
     pacman_t* pacman = &board->pacmans[0];
     pacman->alive = 1;
     pacman->points = points;
 
-    // no file was provided -> defaults 
+    // no file was provided -> defaults
     if (board->pacman_file[0] == '\0') {
         pacman->passo = 0;
         pacman->waiting = 0;
@@ -148,10 +259,10 @@ int read_pacman(board_t* board, int points) {
         for (int i = 0; i < board->height; i++) {
             for (int j = 0; j < board->width; j++) {
                 int idx = i * board->width + j;
-                if (board->board[idx].content == ' ') {
+                if (board_content(board, idx) == ' ') {
                     pacman->pos_x = j;
                     pacman->pos_y = i;
-                    board->board[idx].content = 'P';
+                    board_set_content(board, idx, 'P');
                     goto pacman_inserted;
                 }
             }
@@ -161,33 +272,36 @@ int read_pacman(board_t* board, int points) {
         return 0;
     }
 
-    int fd = open(board->pacman_file, O_RDONLY);
+    file_buf_t fb;
+    if (file_buf_open(&fb, board->pacman_file) == -1) {
+        debug("Error opening file %s\n", board->pacman_file);
+        pacman->n_moves = 0;
+        return 0;
+    }
 
-    int read;
-    char command[MAX_COMMAND_LENGTH];
-    while ((read = read_line(fd, command)) > 0) {
+    char* line;
+    char* args;
+    char* save;
+    while ((line = file_buf_next_line(&fb)) != NULL) {
         // comment
-        if (command[0] == '#' || command[0] == '\0') continue;
-
-        char *word = strtok(command, " \t\n");
-        if (!word) continue;  // skip empty line
+        if (is_skippable(line) || is_blank(line)) continue;
 
-        if (strcmp(word, "PASSO") == 0) {
-            char *arg = strtok(NULL, " \t\n");
+        if (is_keyword(line, "PASSO", &args)) {
+            char *arg = strtok_r(args, " \t", &save);
             if (arg) {
                 pacman->passo = atoi(arg);
                 pacman->waiting = pacman->passo;
                 debug("Pacman passo: %d\n", pacman->passo);
             }
         }
-        else if (strcmp(word, "POS") == 0) {
-            char *arg1 = strtok(NULL, " \t\n");
-            char *arg2 = strtok(NULL, " \t\n");
+        else if (is_keyword(line, "POS", &args)) {
+            char *arg1 = strtok_r(args, " \t", &save);
+            char *arg2 = strtok_r(NULL, " \t", &save);
             if (arg1 && arg2) {
                 pacman->pos_x = atoi(arg1);
                 pacman->pos_y = atoi(arg2);
                 int idx = pacman->pos_y * board->width + pacman->pos_x;
-                board->board[idx].content = 'P';
+                board_set_content(board, idx, 'P');
                 debug("Pacman Pos = %d x %d\n", pacman->pos_x, pacman->pos_y);
             }
         }
@@ -198,74 +312,45 @@ int read_pacman(board_t* board, int points) {
 
     // end of the file contains the moves
     pacman->current_move = 0;
-    
-    // command here still holds the previous line
-    int move = 0;
-    while (read > 0 && move < MAX_MOVES) {
-        if (command[0]== '#' || command[0] == '\0') continue;
-        if (command[0] == 'A' ||
-            command[0] == 'D' ||
-            command[0] == 'W' ||
-            command[0] == 'S' ||
-            command[0] == 'R' ||
-            command[0] == 'G' ||  // FIXME: so para testar
-            command[0] == 'Q') {  // FIXME: so para testar
-                pacman->moves[move].command = command[0];
-                pacman->moves[move].turns = 1;
-                move += 1;
-        }
-        else if (command[0] == 'T' && command[1] == ' ') { 
-            int t = atoi(command+2);
-            if (t > 0) {
-                pacman->moves[move].command = command[0];
-                pacman->moves[move].turns = t;
-                pacman->moves[move].turns_left = t;
-                move += 1;
-            }
-        }
+    pacman->n_moves = read_moves(&fb, line, pacman->moves,
+                                 "ADWSRGQ"); // FIXME: G e Q so para testar
 
-        read = read_line(fd, command);
-    }
-    pacman->n_moves = move;
-
-    close(fd);
+    file_buf_close(&fb);
     return 0;
 }
 
 int read_ghosts(board_t* board) {
     for (int i = 0; i < board->n_ghosts; i++) {
-        int fd = open(board->ghosts_files[i], O_RDONLY);
-        if (fd == -1) {
+        file_buf_t fb;
+        if (file_buf_open(&fb, board->ghosts_files[i]) == -1) {
             // Ghosts are optional, continue with defaults
             continue;
         }
 
         ghost_t* ghost = &board->ghosts[i];
 
-        int read;
-        char command[MAX_COMMAND_LENGTH];
-        while ((read = read_line(fd, command)) > 0) {
-            if (command[0] == '#' || command[0] == '\0') continue;
+        char* line;
+        char* args;
+        char* save;
+        while ((line = file_buf_next_line(&fb)) != NULL) {
+            if (is_skippable(line) || is_blank(line)) continue;
 
-            char *word = strtok(command, " \t\n");
-            if (!word) continue;
-
-            if (strcmp(word, "PASSO") == 0) {
-                char *arg = strtok(NULL, " \t\n");
+            if (is_keyword(line, "PASSO", &args)) {
+                char *arg = strtok_r(args, " \t", &save);
                 if (arg) {
                     ghost->passo = atoi(arg);
                     ghost->waiting = ghost->passo;
                     debug("Ghost passo: %d\n", ghost->passo);
                 }
             }
-            else if (strcmp(word, "POS") == 0) {
-                char *arg1 = strtok(NULL, " \t\n");
-                char *arg2 = strtok(NULL, " \t\n");
+            else if (is_keyword(line, "POS", &args)) {
+                char *arg1 = strtok_r(args, " \t", &save);
+                char *arg2 = strtok_r(NULL, " \t", &save);
                 if (arg1 && arg2) {
                     ghost->pos_x = atoi(arg1);
                     ghost->pos_y = atoi(arg2);
                     int idx = ghost->pos_y * board->width + ghost->pos_x;
-                    board->board[idx].content = 'M';
+                    board_set_content(board, idx, 'M');
                     debug("Ghost Pos = %d x %d\n", ghost->pos_x, ghost->pos_y);
                 }
             }
@@ -275,53 +360,9 @@ int read_ghosts(board_t* board) {
         }
 
         ghost->current_move = 0;
+        ghost->n_moves = read_moves(&fb, line, ghost->moves, "ADWSRC");
 
-        int move = 0;
-        while (read > 0 && move < MAX_MOVES) {
-            if (command[0] == '#' || command[0] == '\0') continue;
-            if (command[0] == 'A' ||
-                command[0] == 'D' ||
-                command[0] == 'W' ||
-                command[0] == 'S' ||
-                command[0] == 'R' ||
-                command[0] == 'C') {
-                ghost->moves[move].command = command[0];
-                ghost->moves[move].turns = 1;
-                move += 1;
-            }
-            else if (command[0] == 'T' && command[1] == ' ') {
-                int t = atoi(command + 2);
-                if (t > 0) {
-                    ghost->moves[move].command = command[0];
-                    ghost->moves[move].turns = t;
-                    ghost->moves[move].turns_left = t;
-                    move += 1;
-                }
-            }
-            read = read_line(fd, command);
-        }
-        ghost->n_moves = move;
-
-        close(fd);
+        file_buf_close(&fb);
     }
     return 0;
 }
-
-int read_line(int fd, char* buf) {
-    int i = 0;
-    char c;
-    ssize_t n;
-
-    while ((n = read(fd, &c, 1)) == 1) {
-        if (c == '\r') continue;
-        if (c == '\n') break;
-        buf[i++] = c;
-        if (i == MAX_COMMAND_LENGTH - 1) break;
-    }
-
-    buf[i] = '\0';
-    if (n == -1) return -1;
-    if (n == 0 && i == 0) return 0;
-    return i;
-}
-
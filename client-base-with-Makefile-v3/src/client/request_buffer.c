@@ -0,0 +1,171 @@
+#define _GNU_SOURCE // syscall()
+#include "request_buffer.h"
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+// Tentativas sem dormir antes de recorrer ao futex (a fila costuma encher ou
+// esvaziar só por instantes). Com um único core não vale a pena: quem
+// desbloquearia a fila não pode correr enquanto se insiste.
+#define SPIN_TRIES 200
+
+// ==================== FUTEX ====================
+
+static void futex_wait(_Atomic uint32_t* addr, uint32_t expected) {
+    // Só dorme se o valor ainda for o esperado (senão volta logo: EAGAIN)
+    syscall(SYS_futex, (uint32_t*)addr, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+
+static void futex_wake(_Atomic uint32_t* addr, int n) {
+    syscall(SYS_futex, (uint32_t*)addr, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0);
+}
+
+// ==================== FILA ====================
+
+int buffer_init(request_buffer_t* buf, int size) {
+    size_t capacity = 2;
+    while (capacity < (size_t)size) capacity <<= 1;
+
+    buf->slots = malloc(capacity * sizeof(request_slot_t));
+    if (!buf->slots) return -1;
+
+    for (size_t i = 0; i < capacity; i++) {
+        atomic_init(&buf->slots[i].seq, i);
+    }
+    buf->mask = capacity - 1;
+    buf->spin = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? SPIN_TRIES : 0;
+    atomic_init(&buf->enqueue_pos, 0);
+    atomic_init(&buf->dequeue_pos, 0);
+    atomic_init(&buf->put_seq, 0);
+    atomic_init(&buf->get_seq, 0);
+    atomic_init(&buf->waiting_consumers, 0);
+    atomic_init(&buf->waiting_producers, 0);
+    return 0;
+}
+
+void buffer_destroy(request_buffer_t* buf) {
+    free(buf->slots);
+    buf->slots = NULL;
+}
+
+int buffer_capacity(const request_buffer_t* buf) {
+    return (int)(buf->mask + 1);
+}
+
+int buffer_try_put(request_buffer_t* buf, const connection_request_t* req) {
+    size_t pos = atomic_load_explicit(&buf->enqueue_pos, memory_order_relaxed);
+    request_slot_t* slot;
+
+    while (1) {
+        slot = &buf->slots[pos & buf->mask];
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+        if (diff == 0) {
+            // Posição livre: tentar reservá-la
+            if (atomic_compare_exchange_weak_explicit(&buf->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return -1; // cheia
+        } else {
+            pos = atomic_load_explicit(&buf->enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    slot->req = *req;
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+    return 0;
+}
+
+int buffer_try_get(request_buffer_t* buf, connection_request_t* req) {
+    size_t pos = atomic_load_explicit(&buf->dequeue_pos, memory_order_relaxed);
+    request_slot_t* slot;
+
+    while (1) {
+        slot = &buf->slots[pos & buf->mask];
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&buf->dequeue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return -1; // vazia
+        } else {
+            pos = atomic_load_explicit(&buf->dequeue_pos, memory_order_relaxed);
+        }
+    }
+
+    *req = slot->req;
+    // Libertar a posição para a volta seguinte dos produtores
+    atomic_store_explicit(&slot->seq, pos + buf->mask + 1, memory_order_release);
+    return 0;
+}
+
+// Os contadores de espera e as palavras do futex usam ordem sequencial: ou
+// quem espera vê a alteração ao voltar a tentar, ou quem a fez vê que há
+// alguém à espera e acorda-o (não há acordares perdidos).
+
+// Um pedido entrou: acordar um consumidor se houver algum à espera
+static void notify_put(request_buffer_t* buf) {
+    atomic_fetch_add(&buf->put_seq, 1);
+    if (atomic_load(&buf->waiting_consumers) > 0) {
+        futex_wake(&buf->put_seq, 1);
+    }
+}
+
+void buffer_put(request_buffer_t* buf, connection_request_t req) {
+    for (int i = 0; i < buf->spin; i++) {
+        if (buffer_try_put(buf, &req) == 0) goto done;
+    }
+
+    while (buffer_try_put(buf, &req) < 0) {
+        atomic_fetch_add(&buf->waiting_producers, 1);
+        uint32_t seen = atomic_load(&buf->get_seq);
+        if (buffer_try_put(buf, &req) == 0) {
+            atomic_fetch_sub(&buf->waiting_producers, 1);
+            break;
+        }
+        futex_wait(&buf->get_seq, seen);
+        atomic_fetch_sub(&buf->waiting_producers, 1);
+    }
+
+done:
+    notify_put(buf);
+}
+
+int buffer_put_nowait(request_buffer_t* buf, const connection_request_t* req) {
+    if (buffer_try_put(buf, req) < 0) return -1;
+    notify_put(buf);
+    return 0;
+}
+
+connection_request_t buffer_get(request_buffer_t* buf) {
+    connection_request_t req;
+    for (int i = 0; i < buf->spin; i++) {
+        if (buffer_try_get(buf, &req) == 0) goto done;
+    }
+
+    while (buffer_try_get(buf, &req) < 0) {
+        atomic_fetch_add(&buf->waiting_consumers, 1);
+        uint32_t seen = atomic_load(&buf->put_seq);
+        if (buffer_try_get(buf, &req) == 0) {
+            atomic_fetch_sub(&buf->waiting_consumers, 1);
+            break;
+        }
+        futex_wait(&buf->put_seq, seen);
+        atomic_fetch_sub(&buf->waiting_consumers, 1);
+    }
+
+done:
+    atomic_fetch_add(&buf->get_seq, 1);
+    if (atomic_load(&buf->waiting_producers) > 0) {
+        futex_wake(&buf->get_seq, 1);
+    }
+    return req;
+}
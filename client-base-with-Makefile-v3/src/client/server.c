@@ -3,6 +3,11 @@
 #include "parser.h"
 #include "display.h"
 #include "protocol.h"
+#include "engine.h"
+#include "level_cache.h"
+#include "leaderboard.h"
+#include "session_input.h"
+#include "debug.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -10,10 +15,13 @@
 #include <fcntl.h>
 #include <signal.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
 #include <pthread.h>
 #include <semaphore.h>
 #include <errno.h>
-#include <dirent.h>
 #include <time.h>
 #include <sys/select.h>
 
@@ -22,46 +30,114 @@ static request_buffer_t connection_buffer;
 static client_session_t *sessions = NULL;
 static int max_sessions = 0;
 static pthread_mutex_t sessions_mutex = PTHREAD_MUTEX_INITIALIZER;
-static volatile sig_atomic_t sigusr1_received = 0;
+static sem_t report_sem;                 // SIGUSR1 -> thread de relatórios
 static char* levels_dir = NULL;
 static char register_pipe_name[100];
+static char* listen_socket_path = NULL;  // -u: ligações por socket Unix
+static int keyframe_interval = DEFAULT_KEYFRAME_INTERVAL;
+static int slow_consumer_ms = DEFAULT_SLOW_CONSUMER_MS;
+static _Atomic unsigned shm_counter = 0;     // nomes únicos das regiões partilhadas
 
-// ==================== BUFFER PRODUTOR-CONSUMIDOR ====================
+// Slots livres de sessions[] (pilha protegida por sessions_mutex)
+static int* free_slots = NULL;
+static int n_free_slots = 0;
+static pthread_cond_t slot_freed = PTHREAD_COND_INITIALIZER;
 
-void buffer_init(request_buffer_t* buf, int size) {
-    buf->buffer = malloc(size * sizeof(connection_request_t));
-    buf->size = size;
-    buf->in = 0;
-    buf->out = 0;
-    pthread_mutex_init(&buf->mutex, NULL);
-    sem_init(&buf->empty, 0, size);
-    sem_init(&buf->full, 0, 0);
+// Latência de admissão: tempo na fila de pedidos e à espera de um slot
+typedef struct {
+    long count;
+    long queue_us_total;
+    long queue_us_max;
+    long slot_us_total;
+    long slot_us_max;
+} admission_stats_t;
+
+static admission_stats_t admission_stats;
+static pthread_mutex_t admission_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// ==================== SLOTS DE SESSÃO ====================
+
+static int slots_init(int n) {
+    free_slots = malloc(n * sizeof(int));
+    if (!free_slots) return -1;
+
+    // Empilhar ao contrário para os primeiros clientes ficarem com os slots 0, 1, ...
+    for (int i = 0; i < n; i++) {
+        free_slots[i] = n - 1 - i;
+    }
+    n_free_slots = n;
+    return 0;
 }
 
-void buffer_destroy(request_buffer_t* buf) {
-    free(buf->buffer);
-    pthread_mutex_destroy(&buf->mutex);
-    sem_destroy(&buf->empty);
-    sem_destroy(&buf->full);
+// Marca o slot do topo da pilha como ocupado pelo cliente (com sessions_mutex)
+static int slot_take(int client_id) {
+    int idx = free_slots[--n_free_slots];
+    atomic_store_explicit(&sessions[idx].client_id, client_id, memory_order_relaxed);
+    atomic_store_explicit(&sessions[idx].points, 0, memory_order_relaxed);
+    atomic_store_explicit(&sessions[idx].active, 1, memory_order_release);
+    leaderboard_add(idx, client_id, 0);
+    return idx;
 }
 
-void buffer_put(request_buffer_t* buf, connection_request_t req) {
-    sem_wait(&buf->empty);
-    pthread_mutex_lock(&buf->mutex);
-    buf->buffer[buf->in] = req;
-    buf->in = (buf->in + 1) % buf->size;
-    pthread_mutex_unlock(&buf->mutex);
-    sem_post(&buf->full);
+// Reserva um slot para o cliente, esperando (sem polling) que algum fique livre
+static int slot_acquire(int client_id) {
+    pthread_mutex_lock(&sessions_mutex);
+    while (n_free_slots == 0) {
+        pthread_cond_wait(&slot_freed, &sessions_mutex);
+    }
+
+    int idx = slot_take(client_id);
+    pthread_mutex_unlock(&sessions_mutex);
+    return idx;
 }
 
-connection_request_t buffer_get(request_buffer_t* buf) {
-    sem_wait(&buf->full);
-    pthread_mutex_lock(&buf->mutex);
-    connection_request_t req = buf->buffer[buf->out];
-    buf->out = (buf->out + 1) % buf->size;
-    pthread_mutex_unlock(&buf->mutex);
-    sem_post(&buf->empty);
-    return req;
+// Como slot_acquire, mas devolve -1 em vez de esperar se não houver slot livre
+static int slot_try_acquire(int client_id) {
+    pthread_mutex_lock(&sessions_mutex);
+    int idx = n_free_slots > 0 ? slot_take(client_id) : -1;
+    pthread_mutex_unlock(&sessions_mutex);
+    return idx;
+}
+
+// Devolve o slot e acorda um worker à espera
+static void slot_release(int idx) {
+    pthread_mutex_lock(&sessions_mutex);
+    atomic_store_explicit(&sessions[idx].active, 0, memory_order_release);
+    leaderboard_remove(idx);
+    free_slots[n_free_slots++] = idx;
+    pthread_cond_signal(&slot_freed);
+    pthread_mutex_unlock(&sessions_mutex);
+}
+
+static void admission_record(const connection_request_t* req,
+                             const struct timespec* dequeued,
+                             const struct timespec* admitted) {
+    long queue_us = timespec_diff_us(dequeued, &req->enqueued);
+    long slot_us = timespec_diff_us(admitted, dequeued);
+
+    pthread_mutex_lock(&admission_mutex);
+    admission_stats.count++;
+    admission_stats.queue_us_total += queue_us;
+    admission_stats.slot_us_total += slot_us;
+    if (queue_us > admission_stats.queue_us_max) admission_stats.queue_us_max = queue_us;
+    if (slot_us > admission_stats.slot_us_max) admission_stats.slot_us_max = slot_us;
+    pthread_mutex_unlock(&admission_mutex);
+}
+
+static void report_admission_stats(void) {
+    pthread_mutex_lock(&admission_mutex);
+    admission_stats_t st = admission_stats;
+    pthread_mutex_unlock(&admission_mutex);
+
+    if (st.count == 0) {
+        fprintf(stderr, "ADMISSÃO: nenhum pedido admitido.\n");
+        return;
+    }
+    fprintf(stderr,
+        "ADMISSÃO: %ld pedidos | fila: média %.3f ms, máx %.3f ms | slot: média %.3f ms, máx %.3f ms\n",
+        st.count,
+        st.queue_us_total / 1000.0 / st.count, st.queue_us_max / 1000.0,
+        st.slot_us_total / 1000.0 / st.count, st.slot_us_max / 1000.0);
 }
 
 // ==================== UTILITÁRIOS ====================
@@ -100,466 +176,860 @@ static int extract_client_id(const char* pipe_path) {
     return atoi(id_str);
 }
 
-static void send_board_update(int notif_fd, board_t* board, int points, int game_over, int victory) {
-    char op_code = OP_CODE_BOARD;
-    int width = board->width;
-    int height = board->height;
-    int tempo = board->tempo;
-    
-    write(notif_fd, &op_code, 1);
-    write(notif_fd, &width, sizeof(int));
-    write(notif_fd, &height, sizeof(int));
-    write(notif_fd, &tempo, sizeof(int));
-    write(notif_fd, &victory, sizeof(int));
-    write(notif_fd, &game_over, sizeof(int));
-    write(notif_fd, &points, sizeof(int));
-    
-    char* board_data = get_board_displayed(board);
-    write(notif_fd, board_data, width * height);
-    free(board_data);
+// ==================== CANAL DE NOTIFICAÇÕES ====================
+// O fd é não bloqueante: cada sessão tem no máximo uma frame em envio e uma
+// frame à espera (sempre o estado mais recente, como keyframe). Um cliente
+// lento nunca bloqueia o motor; se ficar parado mais de slow_consumer_ms é
+// desligado.
+
+static void notif_stream_init(notif_stream_t* stream, int fd, shm_producer_t* ring,
+                              const char* shm_name, int mux_id) {
+    memset(stream, 0, sizeof(notif_stream_t));
+    stream->fd = fd;
+    stream->need_keyframe = 1;
+    stream->mux_id = mux_id;
+    stream->ring = ring;
+    if (ring) snprintf(stream->shm_name, sizeof(stream->shm_name), "%s", shm_name);
+
+    int flags = fcntl(fd, F_GETFL);
+    if (flags != -1) fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+static void notif_stream_close(notif_stream_t* stream) {
+    if (stream->ring) {
+        shm_ring_close(stream->ring);
+        shm_ring_destroy(stream->ring);
+        // Normalmente já foi removido pelo cliente ao mapear a região
+        shm_unlink(stream->shm_name);
+        stream->ring = NULL;
+    }
+    close(stream->fd);
+    free(stream->last_frame);
+    free(stream->frame_buf);
+    free(stream->next_buf);
+    stream->last_frame = NULL;
+    stream->frame_buf = NULL;
+    stream->next_buf = NULL;
+}
+
+static int grow_buffer(char** buf, int* cap, int needed) {
+    if (*cap >= needed) return 0;
+    char* grown = realloc(*buf, needed);
+    if (!grown) return -1;
+    *buf = grown;
+    *cap = needed;
+    return 0;
+}
+
+// Garante os buffers para um tabuleiro width x height (só realoca quando as
+// dimensões mudam)
+static int notif_stream_reserve(notif_stream_t* stream, int width, int height) {
+    int cells = width * height;
+    int max_frame = MUX_HEADER_SIZE + 1 + 6 * (int)sizeof(int) + cells;
+    int max_delta = MUX_HEADER_SIZE + 1 + 4 * (int)sizeof(int) + cells * DELTA_ENTRY_SIZE;
+    int needed = max_frame > max_delta ? max_frame : max_delta;
+
+    // realloc preserva uma frame que ainda esteja a meio do envio
+    if (grow_buffer(&stream->frame_buf, &stream->frame_cap, needed) < 0 ||
+        grow_buffer(&stream->next_buf, &stream->next_cap, max_frame) < 0) {
+        return -1;
+    }
+
+    if (width != stream->last_width || height != stream->last_height) {
+        free(stream->last_frame);
+        stream->last_frame = malloc(cells);
+        if (!stream->last_frame) {
+            stream->last_width = stream->last_height = 0;
+            return -1;
+        }
+        stream->last_width = width;
+        stream->last_height = height;
+        stream->need_keyframe = 1;
+    }
+    return 0;
+}
+
+static inline char* put_int(char* p, int value) {
+    memcpy(p, &value, sizeof(int));
+    return p + sizeof(int);
+}
+
+// Codifica o tabuleiro em out: completo (keyframe) quando necessário ou
+// pedido, senão apenas as células que mudaram desde a última frame (num
+// canal multiplexado, depois do prefixo da sessão). Devolve o tamanho da
+// mensagem.
+static int encode_board_frame(notif_stream_t* stream, board_t* board, char* out, int force_keyframe,
+                              int points, int game_over, int victory) {
+    int cells = board->width * board->height;
+
+    // O tabuleiro mantém a sua própria renderização atualizada pelos movimentos
+    const char* board_data = board->display;
+
+    int keyframe = force_keyframe || stream->need_keyframe || keyframe_interval <= 0 ||
+                   stream->frames_since_keyframe >= keyframe_interval;
+
+    char* p = out;
+    if (stream->mux_id >= 0) {
+        *p++ = OP_CODE_MUX;
+        p = put_int(p, stream->mux_id);
+    }
+    char* body = p;
+
+    if (!keyframe) {
+        *p++ = OP_CODE_BOARD_DELTA;
+        p = put_int(p, victory);
+        p = put_int(p, game_over);
+        p = put_int(p, points);
+        char* count_pos = p;
+        p += sizeof(int);
+
+        int n_changes = 0;
+        for (int i = 0; i < cells; i++) {
+            if (board_data[i] == stream->last_frame[i]) continue;
+            p = put_int(p, i);
+            *p++ = board_data[i];
+            stream->last_frame[i] = board_data[i];
+            n_changes++;
+        }
+        put_int(count_pos, n_changes);
+
+        // Um delta maior do que o próprio tabuleiro não compensa
+        if (n_changes * DELTA_ENTRY_SIZE >= cells) keyframe = 1;
+    }
+
+    if (keyframe) {
+        p = body;
+        *p++ = OP_CODE_BOARD;
+        p = put_int(p, board->width);
+        p = put_int(p, board->height);
+        p = put_int(p, board->tempo);
+        p = put_int(p, victory);
+        p = put_int(p, game_over);
+        p = put_int(p, points);
+        memcpy(p, board_data, cells);
+        memcpy(stream->last_frame, board_data, cells);
+        p += cells;
+        stream->frames_since_keyframe = 0;
+        stream->need_keyframe = 0;
+    } else {
+        stream->frames_since_keyframe++;
+    }
+
+    return (int)(p - out);
+}
+
+// Escreve o estado atual como frame completa do anel partilhado
+static void fill_shm_frame(shm_frame_t* frame, board_t* board, int points, int game_over, int victory) {
+    int cells = board->width * board->height;
+    frame->width = board->width;
+    frame->height = board->height;
+    frame->tempo = board->tempo;
+    frame->victory = victory;
+    frame->game_over = game_over;
+    frame->points = points;
+    memcpy(frame->data, board->display, cells);
+    frame->data[cells] = '\0';
+}
+
+// Põe o estado atual na fila de saída (chamar com o state_lock do tabuleiro;
+// não escreve nada no fd). Se ainda há uma frame em envio, o estado vai como
+// keyframe para a posição de espera, substituindo o que lá estivesse.
+static void queue_board_update(notif_stream_t* stream, board_t* board, int points, int game_over, int victory) {
+    if (stream->broken) return;
+    if (notif_stream_reserve(stream, board->width, board->height) < 0) {
+        return;
+    }
+
+    if (stream->ring) {
+        // Com espaço no anel a frame é escrita diretamente no destino;
+        // senão fica à espera em frame_buf (substituindo a anterior)
+        shm_frame_t* slot = stream->frame_len == 0 ? shm_ring_reserve(stream->ring) : NULL;
+        if (slot) {
+            fill_shm_frame(slot, board, points, game_over, victory);
+            shm_ring_publish(stream->ring);
+        } else {
+            fill_shm_frame((shm_frame_t*)stream->frame_buf, board, points, game_over, victory);
+            stream->frame_len = (int)sizeof(shm_frame_t) + board->width * board->height + 1;
+        }
+        return;
+    }
+
+    if (stream->frame_len == 0) {
+        stream->frame_len = encode_board_frame(stream, board, stream->frame_buf, 0,
+                                               points, game_over, victory);
+        stream->frame_off = 0;
+    } else {
+        stream->next_len = encode_board_frame(stream, board, stream->next_buf, 1,
+                                              points, game_over, victory);
+    }
+}
+
+// Escreve o que a fila de saída tiver, sem bloquear. Devolve 0 se ficou
+// vazia, 1 se o cliente ainda não tem espaço e -1 se o cliente desapareceu.
+// Cada frame sai num write (atómica até PIPE_BUF bytes).
+static void notif_stream_mark_stalled(notif_stream_t* stream) {
+    if (!stream->stalled) {
+        stream->stalled = 1;
+        clock_gettime(CLOCK_MONOTONIC, &stream->stalled_since);
+    }
+}
+
+static int notif_stream_flush(notif_stream_t* stream) {
+    if (stream->ring) {
+        if (stream->frame_len == 0) return 0;
+        shm_frame_t* slot = shm_ring_reserve(stream->ring);
+        if (!slot) {
+            notif_stream_mark_stalled(stream);
+            return 1;
+        }
+        memcpy(slot, stream->frame_buf, stream->frame_len);
+        shm_ring_publish(stream->ring);
+        stream->frame_len = 0;
+        stream->stalled = 0;
+        return 0;
+    }
+
+    while (!stream->broken && stream->frame_len > 0) {
+        ssize_t n = write(stream->fd, stream->frame_buf + stream->frame_off,
+                          stream->frame_len - stream->frame_off);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                notif_stream_mark_stalled(stream);
+                return 1;
+            }
+            stream->broken = 1;
+            stream->frame_len = stream->next_len = 0;
+            return -1;
+        }
+
+        stream->frame_off += n;
+        if (stream->frame_off < stream->frame_len) continue;
+
+        // Frame entregue: avançar para a que estava à espera
+        stream->stalled = 0;
+        stream->frame_len = stream->frame_off = 0;
+        if (stream->next_len > 0) {
+            char* tmp = stream->frame_buf;
+            int tmp_cap = stream->frame_cap;
+            stream->frame_buf = stream->next_buf;
+            stream->frame_cap = stream->next_cap;
+            stream->next_buf = tmp;
+            stream->next_cap = tmp_cap;
+            stream->frame_len = stream->next_len;
+            stream->next_len = 0;
+        }
+    }
+    return stream->broken ? -1 : 0;
+}
+
+// O cliente não lê nada há mais de limit_ms
+static int notif_stream_stalled_for(const notif_stream_t* stream, int limit_ms) {
+    if (!stream->stalled || limit_ms <= 0) return 0;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return timespec_diff_ms(&now, &stream->stalled_since) > limit_ms;
 }
 
 // ==================== SIGNAL HANDLER (EXERCÍCIO 2) ====================
 
 static void sigusr1_handler(int sig) {
     (void)sig;
-    sigusr1_received = 1;
+    // sem_post é async-signal-safe: o relatório é escrito pela thread de
+    // relatórios, fora do ciclo que aceita ligações
+    sem_post(&report_sem);
     // Debug mínimo para confirmar que o sinal é recebido
     const char msg[] = "SIGUSR1 handler called\n";
     write(STDERR_FILENO, msg, sizeof(msg) - 1);
 }
 
-// Estrutura para armazenar clientes ordenados por pontuação
-typedef struct {
-    int client_id;
-    int points;
-} client_score_t;
-
+// Escreve o top 5 num ficheiro temporário e substitui o log com rename():
+// quem o lê vê sempre o relatório anterior ou o novo, nunca um a meio
 static void generate_top5_log() {
-    FILE* log = fopen("top5_clients.log", "w");
+    leaderboard_entry_t top[5];
+    int active = 0;
+    int n = leaderboard_top(top, 5, &active);
+
+    FILE* log = fopen(TOP5_LOG_FILE ".tmp", "w");
     if (!log) {
-        perror("Erro ao criar top5_clients.log");
+        perror("Erro ao criar " TOP5_LOG_FILE);
         return;
     }
     
     fprintf(log, "=== TOP 5 CLIENTES POR PONTUAÇÃO ===\n");
     
-    // Coletar pontuações de todas as sessões ativas
-    client_score_t scores[100];
-    int count = 0;
-    
-    pthread_mutex_lock(&sessions_mutex);
-    if (sessions != NULL) {
-        for (int i = 0; i < max_sessions; i++) {
-            if (sessions[i].active) {
-                scores[count].client_id = sessions[i].client_id;
-                scores[count].points = sessions[i].points;
-                count++;
-                if (count >= 100) break;
-            }
-        }
-    }
-    pthread_mutex_unlock(&sessions_mutex);
-    
-    // Ordenar por pontuação (decrescente)
-    for (int i = 0; i < count - 1; i++) {
-        for (int j = i + 1; j < count; j++) {
-            if (scores[j].points > scores[i].points) {
-                client_score_t temp = scores[i];
-                scores[i] = scores[j];
-                scores[j] = temp;
-            }
-        }
-    }
-    
-    // Escrever top 5
-    int top = count < 5 ? count : 5;
-    for (int i = 0; i < top; i++) {
+    for (int i = 0; i < n; i++) {
         fprintf(log, "%d. Cliente ID: %d - Pontuação: %d\n", 
-                i + 1, scores[i].client_id, scores[i].points);
+                i + 1, top[i].client_id, top[i].points);
     }
     
-    if (count == 0) {
+    if (n == 0) {
         fprintf(log, "Nenhum cliente ativo.\n");
     }
     
-    fclose(log);
-    fprintf(stderr, "SIGUSR1: top5_clients.log gerado com %d clientes ativos.\n", count);
+    if (fclose(log) != 0 || rename(TOP5_LOG_FILE ".tmp", TOP5_LOG_FILE) == -1) {
+        perror("Erro ao escrever " TOP5_LOG_FILE);
+        unlink(TOP5_LOG_FILE ".tmp");
+        return;
+    }
+    fprintf(stderr, "SIGUSR1: top5_clients.log gerado com %d clientes ativos.\n", active);
 }
 
-// Estruturas para o jog
+// Thread de relatórios: acordada pelo handler de SIGUSR1
+static void* report_thread(void* arg) {
+    (void)arg;
 
-typedef struct {
-    int shutdown;
-    pthread_mutex_t mutex;
-    pthread_cond_t cond;
-} game_control_t;
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
 
-typedef struct {
-    board_t* board;
-    int req_fd;
-    int notif_fd;
-    game_control_t* control;
-    int* session_idx;
-    int ghost_index;
-    int had_dots;
-} game_thread_data_t;
-
-// Thread do pacman
-
-static void* pacman_server_thread(void* arg) {
-    game_thread_data_t* data = (game_thread_data_t*)arg;
-    board_t* board = data->board;
-    int req_fd = data->req_fd;
-    game_control_t* control = data->control;
-    
-    pacman_t* pacman = &board->pacmans[0];
-    
     while (1) {
-        pthread_mutex_lock(&control->mutex);
-        if (control->shutdown) {
-            pthread_mutex_unlock(&control->mutex);
+        if (sem_wait(&report_sem) == -1) {
+            if (errno == EINTR) continue;
             break;
         }
-        pthread_mutex_unlock(&control->mutex);
-        
-        if (!pacman->alive) break;
-        
-        sleep_ms(board->tempo * (1 + pacman->passo));
-        
-        char op_code;
-        fd_set readfds;
-        struct timeval tv = {0, 10000};
-        
-        FD_ZERO(&readfds);
-        FD_SET(req_fd, &readfds);
-        
-        int ready = select(req_fd + 1, &readfds, NULL, NULL, &tv);
-        if (ready > 0) {
-            ssize_t bytes = read(req_fd, &op_code, 1);
-            if (bytes > 0) {
-                if (op_code == OP_CODE_DISCONNECT) {
-                    break;
-                }
-                else if (op_code == OP_CODE_PLAY) {
-                    char command;
-                    read(req_fd, &command, 1);
-                    
-                    // Ignorar comando 'G'
-                    if (command == 'G') {
-                        continue;
-                    }
-                    
-                    command_t cmd;
-                    cmd.command = command;
-                    cmd.turns = 1;
-                    cmd.turns_left = 1;
-                    
-                    pthread_rwlock_rdlock(&board->state_lock);
-                    int result = move_pacman(board, 0, &cmd);
-                    
-                    if (result == REACHED_PORTAL) {
-                        pthread_rwlock_unlock(&board->state_lock);
-                        pthread_mutex_lock(&control->mutex);
-                        control->shutdown = 2;
-                        pthread_mutex_unlock(&control->mutex);
-                        break;
-                    }
-                    
-                    if (result == DEAD_PACMAN) {
-                        pthread_rwlock_unlock(&board->state_lock);
-                        break;
-                    }
-                    
-                    pthread_rwlock_unlock(&board->state_lock);
-                }
-            }
-            else if (bytes == 0) {
-                break;
-            }
-        }
+        generate_top5_log();
+        report_admission_stats();
+        input_report_stats();
     }
-    
     return NULL;
 }
 
-// Thread dos fantasmas
+// ==================== PASSOS DO JOGO ====================
 
-static void* ghost_server_thread(void* arg) {
-    game_thread_data_t* data = (game_thread_data_t*)arg;
-    board_t* board = data->board;
-    int ghost_index = data->ghost_index;
-    game_control_t* control = data->control;
-    
-    if (ghost_index < 0 || ghost_index >= board->n_ghosts) {
-        return NULL;
-    }
-    
-    ghost_t* ghost = &board->ghosts[ghost_index];
-    
-    while (1) {
-        pthread_mutex_lock(&control->mutex);
-        if (control->shutdown) {
-            pthread_mutex_unlock(&control->mutex);
-            break;
-        }
-        pthread_mutex_unlock(&control->mutex);
-        
-        sleep_ms(board->tempo * (1 + ghost->passo));
+// Resultado de um passo: continuar, terminar a sessão ou passar de nível
+enum {
+    STEP_CONTINUE = 0,
+    STEP_END = 1,
+    STEP_NEXT_LEVEL = 2,
+};
 
-        pthread_rwlock_rdlock(&board->state_lock);
+// Aplica ao pacman o comando que a política de entrada escolher. A thread de
+// entrada já leu o FIFO: aqui só se consulta o buffer da sessão.
+static int pacman_step(board_t* board, int session_idx) {
+    char command;
+    int input = input_next(session_idx, &command);
+    if (input == INPUT_CLOSED) return STEP_END;
+    if (input == INPUT_NONE) return STEP_CONTINUE;
 
-        // Proteger contra n_moves == 0 (evita divisão por zero)
-        if (ghost->n_moves <= 0) {
-            pthread_rwlock_unlock(&board->state_lock);
-            continue;
-        }
+    command_t cmd;
+    cmd.command = command;
+    cmd.turns = 1;
+    cmd.turns_left = 1;
 
+    pthread_rwlock_rdlock(&board->state_lock);
+    int result = move_pacman(board, 0, &cmd);
+    pthread_rwlock_unlock(&board->state_lock);
+
+    if (result == REACHED_PORTAL) return STEP_NEXT_LEVEL;
+    if (result == DEAD_PACMAN) return STEP_END;
+    return STEP_CONTINUE;
+}
+
+// Avança um fantasma segundo o seu ficheiro de movimentos
+static void ghost_step(board_t* board, int ghost_index) {
+    ghost_t* ghost = &board->ghosts[ghost_index];
+
+    pthread_rwlock_rdlock(&board->state_lock);
+
+    // Proteger contra n_moves == 0 (evita divisão por zero)
+    if (ghost->n_moves > 0) {
         command_t cmd;
         cmd.command = ghost->moves[ghost->current_move % ghost->n_moves].command;
         cmd.turns = 1;
         cmd.turns_left = 1;
 
         move_ghost(board, ghost_index, &cmd);
-        pthread_rwlock_unlock(&board->state_lock);
     }
-    
-    return NULL;
+
+    pthread_rwlock_unlock(&board->state_lock);
 }
 
-// Thread de notificação
+// Publica a pontuação, deteta fim de jogo e envia o tabuleiro ao cliente
+static int notify_step(board_t* board, notif_stream_t* notif, int session_idx) {
+    // Despachar primeiro o que ficou por enviar (sem locks do tabuleiro)
+    notif_stream_flush(notif);
 
-static void* notification_thread(void* arg) {
-    game_thread_data_t* data = (game_thread_data_t*)arg;
-    board_t* board = data->board;
-    int notif_fd = data->notif_fd;
-    game_control_t* control = data->control;
-    int* session_idx = data->session_idx;
-    
-        // Enviar board inicial IMEDIATAMENTE
-        pthread_rwlock_rdlock(&board->state_lock);
-        send_board_update(notif_fd, board, board->pacmans[0].points, 0, 0);
-        pthread_rwlock_unlock(&board->state_lock);
-    
-    while (1) {
-        pthread_mutex_lock(&control->mutex);
-        if (control->shutdown) {
-            pthread_mutex_unlock(&control->mutex);
-            break;
-        }
-        pthread_mutex_unlock(&control->mutex);
-        
-        sleep_ms(board->tempo);
-        
-        pthread_rwlock_rdlock(&board->state_lock);
-        
-        int points = board->pacmans[0].points;
-        int game_over = !board->pacmans[0].alive;
-        int victory = 0;
-        
-        if (session_idx && *session_idx >= 0) {
-            pthread_mutex_lock(&sessions_mutex);
-            sessions[*session_idx].points = points;
-            pthread_mutex_unlock(&sessions_mutex);
-        }
-        
-        int dots_remaining = 0;
-        for (int i = 0; i < board->width * board->height; i++) {
-            if (board->board[i].has_dot) {
-                dots_remaining = 1;
-                break;
-            }
-        }
+    pthread_rwlock_rdlock(&board->state_lock);
 
-        for (int i = 0; i < board->width * board->height; i++) {
-            if (board->board[i].has_portal && board->board[i].content == 'P') {
-                victory = 1;
-                break;
-            }
-        }
+    int points = board->pacmans[0].points;
+    int game_over = !board->pacmans[0].alive;
+    int victory = 0;
 
-        // Só considerar vitória por "sem pontos" se este nível chegou a ter dots
-        if (data->had_dots && !dots_remaining) {
-            victory = 1;
-        }
+    if (session_idx >= 0) {
+        // A classificação só é tocada quando a pontuação muda
+        int old = atomic_exchange_explicit(&sessions[session_idx].points, points,
+                                           memory_order_relaxed);
+        if (old != points) leaderboard_update(session_idx, points);
+    }
 
-        send_board_update(notif_fd, board, points, game_over, victory);
-        
-        if (game_over || victory) {
-            pthread_mutex_lock(&control->mutex);
-            if (victory) control->shutdown = 2;
-            else control->shutdown = 1;
-            pthread_mutex_unlock(&control->mutex);
-        }
-        
-        pthread_rwlock_unlock(&board->state_lock);
+    // Contadores mantidos por move_pacman: custo constante por tick.
+    // Só considerar vitória por "sem pontos" se este nível chegou a ter dots
+    if (board->portal_reached || (board->n_dots > 0 && board->dots_left == 0)) {
+        victory = 1;
     }
-    
-    return NULL;
+
+    // Só se monta a frame com o lock; a escrita é feita já sem ele
+    queue_board_update(notif, board, points, game_over, victory);
+
+    pthread_rwlock_unlock(&board->state_lock);
+
+    notif_stream_flush(notif);
+
+    if (victory) return STEP_NEXT_LEVEL;
+    if (game_over) return STEP_END;
+
+    if (notif_stream_stalled_for(notif, slow_consumer_ms)) {
+        fprintf(stderr, "Cliente lento (slot %d): sem leituras há mais de %d ms, a desligar\n",
+                session_idx, slow_consumer_ms);
+        notif->broken = 1;
+        return STEP_END;
+    }
+    return STEP_CONTINUE;
 }
 
-// Thread principal do JOGO
+// ==================== NÍVEIS ====================
 
-typedef struct {
-    int client_id;
-    int req_fd;
-    int notif_fd;
-    char* levels_dir;
-} client_game_args_t;
-
-static void* client_game_thread(void* arg) {
-    client_game_args_t* args = (client_game_args_t*)arg;
-    int client_id = args->client_id;
-    int req_fd = args->req_fd;
-    int notif_fd = args->notif_fd;
-    char* levels_dir = args->levels_dir;
-    free(args);
-    
+// Instancia um nível da cache para a sessão
+static int load_session_level(board_t* board, int level_index, int accumulated_points) {
+    const board_t* level = level_cache_get(level_index);
+    if (!level || load_level_from(board, level, accumulated_points) < 0) {
+        fprintf(stderr, "ERRO: load_level falhou para o nível %d\n", level_index);
+        return -1;
+    }
+
+    fprintf(stderr,
+        "DEBUG: Nível carregado: %s, width=%d, height=%d, tempo=%d, n_pacmans=%d\n",
+        board->level_name, board->width, board->height,
+        board->tempo, board->n_pacmans);
+    return 0;
+}
+
+// Tempo máximo a escoar frames no fim da sessão
+static int drain_limit_ms(void) {
+    return slow_consumer_ms > 0 ? slow_consumer_ms : DEFAULT_SLOW_CONSUMER_MS;
+}
+
+// ==================== CANAIS MULTIPLEXADOS ====================
+// Um cliente abre um canal por socket (TRANSPORT_MUX) e dentro dele quantas
+// sessões quiser, cada uma com o seu session_id. As sessões são iguais às
+// outras (slot, motor, fila de saída); só a entrada passa pela thread do
+// canal e as frames levam o prefixo OP_CODE_MUX.
+
+// Envia msg à sessão mux_id do canal fd. As outras mensagens da sessão são
+// frames escritas pelo motor; estas (resposta e fim) podem esperar um pouco
+// por espaço, até timeout_ms.
+static int mux_send(int fd, int mux_id, const char* msg, int len, int timeout_ms) {
+    char packet[MUX_HEADER_SIZE + 3 + SHM_NAME_FIELD_LENGTH];
+    if (len > (int)sizeof(packet) - MUX_HEADER_SIZE) return -1;
+
+    packet[0] = OP_CODE_MUX;
+    put_int(packet + 1, mux_id);
+    memcpy(packet + MUX_HEADER_SIZE, msg, len);
+
+    for (int attempt = 0; attempt < 3; attempt++) {
+        // SOCK_SEQPACKET: o datagrama sai inteiro ou não sai
+        if (send(fd, packet, MUX_HEADER_SIZE + len, 0) >= 0) return 0;
+        if (errno == EINTR) continue;
+        if (errno != EAGAIN && errno != EWOULDBLOCK) return -1;
+
+        struct pollfd pfd = {fd, POLLOUT, 0};
+        if (poll(&pfd, 1, timeout_ms) <= 0) return -1;
+    }
+    return -1;
+}
+
+// Resposta a OP_CODE_CONNECT dentro do canal (formato de OP_CODE_CONNECT_EX)
+static int mux_reply(int fd, int mux_id, int result) {
+    char response[3 + SHM_NAME_FIELD_LENGTH] = {OP_CODE_CONNECT, (char)result, TRANSPORT_PIPE};
+    return mux_send(fd, mux_id, response, sizeof(response), drain_limit_ms());
+}
+
+static void mux_unref(mux_conn_t* mux) {
+    pthread_mutex_lock(&mux->lock);
+    int refs = --mux->refs;
+    pthread_mutex_unlock(&mux->lock);
+    if (refs > 0) return;
+
+    close(mux->req_fd);
+    close(mux->notif_fd);
+    pthread_mutex_destroy(&mux->lock);
+    free(mux->slot_of);
+    free(mux);
+}
+
+// A sessão mux_id deixou o slot: deixa de receber comandos e, se o cliente
+// ainda lá estiver, fica a saber que terminou (notif_fd é a cópia da sessão)
+static void mux_session_finished(mux_conn_t* mux, int mux_id, int notif_fd, int notify) {
+    pthread_mutex_lock(&mux->lock);
+    mux->slot_of[mux_id] = MUX_SLOT_FREE;
+    pthread_mutex_unlock(&mux->lock);
+
+    if (notify) {
+        char end = OP_CODE_DISCONNECT;
+        mux_send(notif_fd, mux_id, &end, 1, NOTIF_DRAIN_PERIOD_MS);
+    }
+}
+
+// OP_CODE_CONNECT dentro do canal: segue para os workers como qualquer outro
+// pedido. A thread do canal é a única a ler os comandos de todas as suas
+// sessões e nunca espera pela fila global: cheia, o pedido é recusado
+// Recusa um pedido já aceite pelo canal: liberta o session_id e a referência
+// que o pedido levava
+static void mux_refuse_session(mux_conn_t* mux, int mux_id) {
+    pthread_mutex_lock(&mux->lock);
+    mux->slot_of[mux_id] = MUX_SLOT_FREE;
+    pthread_mutex_unlock(&mux->lock);
+    mux_reply(mux->notif_fd, mux_id, 1);
+    mux_unref(mux);
+}
+
+// O cliente espera pela resposta, por isso o pedido nunca fica à espera de
+// lugar: com a fila de admissão cheia é recusado aqui, e sem slot livre é
+// recusado pelo worker (ver worker_thread)
+static void mux_request_session(mux_conn_t* mux, int mux_id) {
+    pthread_mutex_lock(&mux->lock);
+    int busy = mux->slot_of[mux_id] != MUX_SLOT_FREE;
+    if (!busy) {
+        mux->slot_of[mux_id] = MUX_SLOT_PENDING;
+        mux->refs++;
+    }
+    pthread_mutex_unlock(&mux->lock);
+
+    if (busy) {
+        mux_reply(mux->notif_fd, mux_id, 1);
+        return;
+    }
+
+    connection_request_t req;
+    memset(&req, 0, sizeof(req));
+    req.client_id = mux_id;
+    req.transport = TRANSPORT_PIPE;
+    req.req_fd = req.notif_fd = -1;
+    req.mux = mux;
+    req.mux_id = mux_id;
+    clock_gettime(CLOCK_MONOTONIC, &req.enqueued);
+    if (buffer_put_nowait(&connection_buffer, &req) == 0) return;
+    mux_refuse_session(mux, mux_id);
+}
+
+static void* mux_thread(void* arg) {
+    mux_conn_t* mux = arg;
+
+    // Bloquear SIGUSR1 (apenas thread anfitriã recebe)
     sigset_t set;
     sigemptyset(&set);
     sigaddset(&set, SIGUSR1);
     pthread_sigmask(SIG_BLOCK, &set, NULL);
-    
-    int session_idx = -1;
-    pthread_mutex_lock(&sessions_mutex);
-    for (int i = 0; i < max_sessions; i++) {
-        if (sessions[i].active && sessions[i].client_id == client_id) {
-            session_idx = i;
-            break;
+
+    char msg[MUX_HEADER_SIZE + PLAY_BATCH_HEADER_SIZE + MAX_PLAY_BATCH * PLAY_BATCH_ENTRY_SIZE];
+    while (1) {
+        ssize_t n = recv(mux->req_fd, msg, sizeof(msg), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        if (n <= MUX_HEADER_SIZE || msg[0] != OP_CODE_MUX) continue;
+
+        int mux_id;
+        memcpy(&mux_id, msg + 1, sizeof(int));
+        if (mux_id < 0 || mux_id >= MUX_MAX_SESSIONS) continue;
+
+        const char* inner = msg + MUX_HEADER_SIZE;
+        if (inner[0] == OP_CODE_CONNECT) {
+            mux_request_session(mux, mux_id);
+            continue;
         }
+
+        // Com o lock do canal o slot não pode ser libertado a meio
+        pthread_mutex_lock(&mux->lock);
+        int slot = mux->slot_of[mux_id];
+        if (slot >= 0) input_feed(slot, inner, (int)(n - MUX_HEADER_SIZE));
+        pthread_mutex_unlock(&mux->lock);
     }
-    pthread_mutex_unlock(&sessions_mutex);
-    
-    if (session_idx == -1) {
-        close(req_fd);
-        close(notif_fd);
-        return NULL;
+
+    // O cliente fechou o canal: todas as sessões abertas terminam
+    char disconnect = OP_CODE_DISCONNECT;
+    pthread_mutex_lock(&mux->lock);
+    mux->closed = 1;
+    for (int i = 0; i < MUX_MAX_SESSIONS; i++) {
+        if (mux->slot_of[i] >= 0) input_feed(mux->slot_of[i], &disconnect, 1);
     }
-    
-    DIR* level_dir = opendir(levels_dir);
-    if (!level_dir) {
-        close(req_fd);
-        close(notif_fd);
-        return NULL;
+    pthread_mutex_unlock(&mux->lock);
+
+    mux_unref(mux);
+    return NULL;
+}
+
+// Aceita um canal multiplexado (pedido por socket com TRANSPORT_MUX)
+static void mux_open(const connection_request_t* req) {
+    mux_conn_t* mux = calloc(1, sizeof(mux_conn_t));
+    int* slot_of = malloc(MUX_MAX_SESSIONS * sizeof(int));
+    char response[3 + SHM_NAME_FIELD_LENGTH] = {OP_CODE_CONNECT, 0, TRANSPORT_MUX};
+    pthread_t tid;
+
+    if (!mux || !slot_of ||
+        write(req->notif_fd, response, sizeof(response)) != (ssize_t)sizeof(response)) {
+        free(mux);
+        free(slot_of);
+        close(req->req_fd);
+        close(req->notif_fd);
+        return;
     }
-    
-    char* level_files[100];
-    int num_levels = 0;
-    struct dirent* entry;
-    
-    while ((entry = readdir(level_dir)) != NULL && num_levels < 100) {
-        if (entry->d_name[0] == '.') continue;
-        
-        char* dot = strrchr(entry->d_name, '.');
-        if (dot && strcmp(dot, ".lvl") == 0) {
-            level_files[num_levels] = strdup(entry->d_name);
-            num_levels++;
-        }
+
+    for (int i = 0; i < MUX_MAX_SESSIONS; i++) slot_of[i] = MUX_SLOT_FREE;
+    mux->req_fd = req->req_fd;
+    mux->notif_fd = req->notif_fd;
+    mux->client_id = req->client_id;
+    mux->slot_of = slot_of;
+    mux->refs = 1;
+    pthread_mutex_init(&mux->lock, NULL);
+
+    if (pthread_create(&tid, NULL, mux_thread, mux) != 0) {
+        mux_unref(mux);
+        return;
     }
-    closedir(level_dir);
-    
-    if (num_levels == 0) {
-        close(req_fd);
-        close(notif_fd);
-        return NULL;
+    pthread_detach(tid);
+    fprintf(stderr, "Canal multiplexado aberto (cliente %d)\n", req->client_id);
+}
+
+// ==================== SESSÕES DE JOGO ====================
+// Cada sessão é uma tarefa do motor. O pacman, cada fantasma e as
+// notificações são eventos independentes no escalonador central, com prazos
+// absolutos: não há threads por entidade nem sleeps relativos.
+
+// Tipos de evento de uma sessão
+enum {
+    EVENT_PACMAN = 0,
+    EVENT_GHOST = 1,
+    EVENT_NOTIFY = 2,
+    EVENT_DRAIN = 3,        // sessão a terminar: escoar as últimas frames
+};
+
+typedef struct {
+    engine_task_t task;         // primeiro campo: task -> sessão
+    pthread_mutex_t lock;       // serializa os eventos da sessão
+    int req_fd;                 // -1 numa sessão de um canal multiplexado
+    notif_stream_t notif;
+    mux_conn_t* mux;
+    int mux_id;
+    int session_idx;
+    int current_level;          // índice do nível na cache
+    board_t board;
+    int level_loaded;
+    unsigned gen;               // incrementa a cada nível: invalida eventos antigos
+    int live_events;            // eventos desta sessão ainda no escalonador
+    int finished;
+} game_session_t;
+
+// Liberta a sessão quando já terminou e nenhum evento a referencia
+// (chamar com s->lock; devolve 1 se a sessão foi libertada)
+static int session_release_if_done(game_session_t* s) {
+    if (!s->finished || s->live_events > 0) return 0;
+
+    pthread_mutex_unlock(&s->lock);
+    pthread_mutex_destroy(&s->lock);
+    free(s);
+    return 1;
+}
+
+// Termina a sessão: fecha os pipes e liberta o slot (chamar com s->lock)
+static void session_finish(game_session_t* s) {
+    if (s->mux) {
+        mux_session_finished(s->mux, s->mux_id, s->notif.fd, !s->notif.broken);
     }
-    
-    int current_level = 0;
-    while (current_level < num_levels) {
-        board_t game_board;
-        memset(&game_board, 0, sizeof(board_t));
-        
+    input_detach(s->session_idx);
+    if (s->req_fd != -1) close(s->req_fd);
+    notif_stream_close(&s->notif);
+    if (s->mux) mux_unref(s->mux);
+
+    slot_release(s->session_idx);
+
+    s->gen++;
+    s->finished = 1;
+}
+
+// Carrega o próximo nível válido e agenda as suas entidades a partir de
+// agora (chamar com s->lock). Devolve -1 se não há mais níveis.
+static int session_load_level(game_session_t* s) {
+    while (s->current_level < level_cache_count()) {
         int accumulated_points = 0;
-        if (current_level > 0) {
-            pthread_mutex_lock(&sessions_mutex);
-            accumulated_points = sessions[session_idx].points;
-            pthread_mutex_unlock(&sessions_mutex);
-        }
-        
-        if (load_level(&game_board, level_files[current_level], levels_dir, accumulated_points) < 0) {
-            fprintf(stderr, "ERRO: load_level falhou para %s\n", level_files[current_level]);
-            free(level_files[current_level]);
-            current_level++;
-            continue;
-        }
-        
-        int dots_count = 0;
-        for (int i = 0; i < game_board.width * game_board.height; i++) {
-            if (game_board.board[i].has_dot) dots_count++;
+        if (s->current_level > 0) {
+            accumulated_points = atomic_load_explicit(&sessions[s->session_idx].points,
+                                                      memory_order_relaxed);
         }
 
-        fprintf(stderr,
-            "DEBUG: Nível carregado: %s, width=%d, height=%d, tempo=%d, n_pacmans=%d\n",
-            level_files[current_level], game_board.width, game_board.height,
-            game_board.tempo, game_board.n_pacmans);
-        
-        free(level_files[current_level]);
-        
-        game_control_t control;
-        control.shutdown = 0;
-        pthread_mutex_init(&control.mutex, NULL);
-        pthread_cond_init(&control.cond, NULL);
-        
-        game_thread_data_t shared_data;
-        shared_data.board = &game_board;
-        shared_data.req_fd = req_fd;
-        shared_data.notif_fd = notif_fd;
-        shared_data.control = &control;
-        shared_data.session_idx = &session_idx;
-        shared_data.ghost_index = -1;
-        shared_data.had_dots = (dots_count > 0);
-        
-        pthread_t pacman_tid, notif_tid;
-        pthread_t* ghost_tids = malloc(game_board.n_ghosts * sizeof(pthread_t));
-        game_thread_data_t* ghost_datas = malloc(game_board.n_ghosts * sizeof(game_thread_data_t));
-        
-        pthread_create(&pacman_tid, NULL, pacman_server_thread, &shared_data);
-        
-        for (int i = 0; i < game_board.n_ghosts; i++) {
-            memcpy(&ghost_datas[i], &shared_data, sizeof(game_thread_data_t));
-            ghost_datas[i].ghost_index = i;
-            pthread_create(&ghost_tids[i], NULL, ghost_server_thread, &ghost_datas[i]);
+        if (load_session_level(&s->board, s->current_level, accumulated_points) == 0) {
+            break;
         }
-        
-        pthread_create(&notif_tid, NULL, notification_thread, &shared_data);
-        
-        pthread_join(pacman_tid, NULL);
-        
-        pthread_mutex_lock(&control.mutex);
-        if (control.shutdown == 0) control.shutdown = 1;
-        pthread_mutex_unlock(&control.mutex);
-        
-        pthread_join(notif_tid, NULL);
-        for (int i = 0; i < game_board.n_ghosts; i++) {
-            pthread_join(ghost_tids[i], NULL);
+        s->current_level++;
+    }
+
+    if (s->current_level >= level_cache_count()) {
+        return -1;
+    }
+
+    // Lugar no escalonador para todos os eventos do nível antes de contar
+    // com eles em live_events: sem memória, a sessão termina aqui
+    board_t* board = &s->board;
+    if (engine_reserve(2 + board->n_ghosts) < 0) {
+        unload_level(board);
+        return -1;
+    }
+    s->level_loaded = 1;
+    s->gen++;
+
+    // Enviar board inicial IMEDIATAMENTE (completo: é um tabuleiro novo)
+    s->notif.need_keyframe = 1;
+    pthread_rwlock_rdlock(&board->state_lock);
+    queue_board_update(&s->notif, board, board->pacmans[0].points, 0, 0);
+    pthread_rwlock_unlock(&board->state_lock);
+    notif_stream_flush(&s->notif);
+
+    struct timespec now, due;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    due = now;
+    timespec_add_ms(&due, board->tempo * (1 + board->pacmans[0].passo));
+    engine_schedule(&s->task, EVENT_PACMAN, 0, s->gen, &due);
+
+    for (int i = 0; i < board->n_ghosts; i++) {
+        due = now;
+        timespec_add_ms(&due, board->tempo * (1 + board->ghosts[i].passo));
+        engine_schedule(&s->task, EVENT_GHOST, i, s->gen, &due);
+    }
+
+    due = now;
+    timespec_add_ms(&due, board->tempo);
+    engine_schedule(&s->task, EVENT_NOTIFY, 0, s->gen, &due);
+
+    s->live_events += 2 + board->n_ghosts;
+    return 0;
+}
+
+// Fecha o nível atual: envia o estado final, liberta o tabuleiro e passa ao
+// seguinte ou termina a sessão (chamar com s->lock)
+static void session_end_level(game_session_t* s, int result, int notified) {
+    if (!notified) {
+        notify_step(&s->board, &s->notif, s->session_idx);
+    }
+
+    unload_level(&s->board);
+    s->level_loaded = 0;
+    s->gen++;
+
+    if (result == STEP_NEXT_LEVEL) {
+        s->current_level++;
+        if (session_load_level(s) == 0) return;
+    }
+
+    // Ainda há frames para o cliente (p.ex. o estado final): escoá-las em
+    // eventos do motor em vez de bloquear à espera dele (sem lugar no
+    // escalonador, termina já)
+    if (notif_stream_flush(&s->notif) > 0 && engine_reserve(1) == 0) {
+        struct timespec due;
+        clock_gettime(CLOCK_MONOTONIC, &due);
+        timespec_add_ms(&due, NOTIF_DRAIN_PERIOD_MS);
+        engine_schedule(&s->task, EVENT_DRAIN, 0, s->gen, &due);
+        s->live_events++;
+        return;
+    }
+
+    session_finish(s);
+}
+
+static int session_run_event(engine_task_t* task, engine_event_t* ev) {
+    game_session_t* s = (game_session_t*)task;
+
+    pthread_mutex_lock(&s->lock);
+
+    // Evento de um nível que já terminou: descartar
+    if (ev->gen != s->gen || (!s->level_loaded && ev->kind != EVENT_DRAIN)) {
+        s->live_events--;
+        if (!session_release_if_done(s)) pthread_mutex_unlock(&s->lock);
+        return 0;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    if (ev->kind == EVENT_DRAIN) {
+        if (notif_stream_flush(&s->notif) > 0 &&
+            !notif_stream_stalled_for(&s->notif, drain_limit_ms())) {
+            pthread_mutex_unlock(&s->lock);
+            engine_next_deadline(&ev->due, NOTIF_DRAIN_PERIOD_MS, &now);
+            return 1;
         }
-        
-        free(ghost_tids);
-        free(ghost_datas);
-        
-        pthread_mutex_lock(&control.mutex);
-        int next_level = (control.shutdown == 2);
-        pthread_mutex_unlock(&control.mutex);
-        
-        pthread_mutex_destroy(&control.mutex);
-        pthread_cond_destroy(&control.cond);
-        unload_level(&game_board);
-        
-        if (!next_level) {
+        session_finish(s);
+        s->live_events--;
+        if (!session_release_if_done(s)) pthread_mutex_unlock(&s->lock);
+        return 0;
+    }
+
+    board_t* board = &s->board;
+    int result = STEP_CONTINUE;
+    int period = board->tempo;
+
+    switch (ev->kind) {
+        case EVENT_PACMAN:
+            result = pacman_step(board, s->session_idx);
+            period = board->tempo * (1 + board->pacmans[0].passo);
+            break;
+        case EVENT_GHOST:
+            ghost_step(board, ev->index);
+            period = board->tempo * (1 + board->ghosts[ev->index].passo);
+            if (!board->pacmans[0].alive) result = STEP_END;
+            break;
+        case EVENT_NOTIFY:
+            result = notify_step(board, &s->notif, s->session_idx);
             break;
-        }
-        
-        current_level++;
     }
-    
-    close(req_fd);
-    close(notif_fd);
-    
-    pthread_mutex_lock(&sessions_mutex);
-    sessions[session_idx].active = 0;
-    pthread_mutex_unlock(&sessions_mutex);
-    
-    return NULL;
+
+    if (result != STEP_CONTINUE) {
+        // O nível acabou: este evento (e os restantes do nível) caducam
+        session_end_level(s, result, ev->kind == EVENT_NOTIFY);
+        s->live_events--;
+        if (!session_release_if_done(s)) pthread_mutex_unlock(&s->lock);
+        return 0;
+    }
+
+    pthread_mutex_unlock(&s->lock);
+
+    // Prazo absoluto seguinte: sem deriva acumulada entre ticks
+    engine_next_deadline(&ev->due, period, &now);
+    return 1;
+}
+
+// Com mux, a entrada do slot já foi ligada ao canal pelo worker
+static int session_start(int req_fd, int notif_fd, int session_idx,
+                         shm_producer_t* ring, const char* shm_name,
+                         mux_conn_t* mux, int mux_id) {
+    game_session_t* s = calloc(1, sizeof(game_session_t));
+    if (!s) return -1;
+
+    s->task.run = session_run_event;
+    s->req_fd = req_fd;
+    notif_stream_init(&s->notif, notif_fd, ring, shm_name, mux ? mux_id : -1);
+    s->session_idx = session_idx;
+    s->mux = mux;
+    s->mux_id = mux_id;
+    pthread_mutex_init(&s->lock, NULL);
+
+    if (!mux && input_attach(session_idx, req_fd) < 0) {
+        pthread_mutex_destroy(&s->lock);
+        free(s);
+        return -1;
+    }
+
+    pthread_mutex_lock(&s->lock);
+    if (session_load_level(s) < 0) {
+        pthread_mutex_unlock(&s->lock);
+        input_detach(session_idx);
+        pthread_mutex_destroy(&s->lock);
+        free(s);
+        return -1;
+    }
+    pthread_mutex_unlock(&s->lock);
+    return 0;
 }
 
 // Thread anfitriã
@@ -609,12 +1079,6 @@ void* host_thread(void* arg) {
     fprintf(stderr, "HOST THREAD: FIFO aberto, aguardando clientes...\n");
     
     while (1) {
-        // Verificar sigusr1
-        if (sigusr1_received) {
-            sigusr1_received = 0;
-            generate_top5_log();
-        }
-        
         // Ler pedido de conexão
         char op_code;
         ssize_t bytes = read(reg_fd, &op_code, 1);
@@ -627,8 +1091,8 @@ void* host_thread(void* arg) {
 
             // bytes < 0: erro na leitura
             if (errno == EINTR) {
-                // Leitura interrompida por sinal (por exemplo, SIGUSR1).
-                // Voltar ao topo do ciclo para tratar sigusr1_received.
+                // Leitura interrompida por sinal (por exemplo, SIGUSR1, já
+                // entregue à thread de relatórios): voltar a ler.
                 continue;
             }
 
@@ -636,12 +1100,14 @@ void* host_thread(void* arg) {
             break;
         }
         
-        if (op_code != OP_CODE_CONNECT) continue;
+        if (op_code != OP_CODE_CONNECT && op_code != OP_CODE_CONNECT_EX) continue;
         
         char req_pipe[40], notif_pipe[40];
+        char transport = TRANSPORT_PIPE;
         
         if (read(reg_fd, req_pipe, 40) != 40) continue;
         if (read(reg_fd, notif_pipe, 40) != 40) continue;
+        if (op_code == OP_CODE_CONNECT_EX && read(reg_fd, &transport, 1) != 1) continue;
 
         // Garantir terminação em '\0' para uso seguro em open()
         req_pipe[39] = '\0';
@@ -652,8 +1118,12 @@ void* host_thread(void* arg) {
         strncpy(req.req_pipe_path, req_pipe, 40);
         strncpy(req.notif_pipe_path, notif_pipe, 40);
         req.client_id = extract_client_id(req_pipe);
+        // Pedido antigo (OP_CODE_CONNECT): resposta de 2 bytes, sempre FIFO
+        req.transport = op_code == OP_CODE_CONNECT_EX ? transport : -1;
+        req.req_fd = req.notif_fd = -1;
+        clock_gettime(CLOCK_MONOTONIC, &req.enqueued);
         
-        // Inserir no buffer (bloqueia se cheio - max_games)
+        // Inserir no buffer (bloqueia se cheio)
         buffer_put(&connection_buffer, req);
     }
     
@@ -664,6 +1134,153 @@ void* host_thread(void* arg) {
 
 // thread worker (Gestora)
 
+// Thread de ligações por socket Unix (-u)
+
+// Lê o pedido de ligação (um datagrama com os dois canais em SCM_RIGHTS).
+// Devolve 0 e preenche req, ou -1 se o pedido não for válido.
+static int read_socket_request(int conn_fd, connection_request_t* req) {
+    char msg[SOCKET_CONNECT_SIZE];
+    struct iovec iov = {msg, sizeof(msg)};
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(2 * sizeof(int))];
+    } control;
+
+    struct msghdr mh;
+    memset(&mh, 0, sizeof(mh));
+    mh.msg_iov = &iov;
+    mh.msg_iovlen = 1;
+    mh.msg_control = control.buf;
+    mh.msg_controllen = sizeof(control.buf);
+
+    ssize_t n = recvmsg(conn_fd, &mh, 0);
+
+    int fds[2] = {-1, -1};
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&mh);
+    if (n > 0 && cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+        int n_fds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        memcpy(fds, CMSG_DATA(cmsg), (n_fds < 2 ? n_fds : 2) * sizeof(int));
+        for (int i = 2; i < n_fds; i++) {
+            int extra;
+            memcpy(&extra, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+            close(extra);
+        }
+    }
+
+    if (n != SOCKET_CONNECT_SIZE || msg[0] != OP_CODE_CONNECT || fds[0] == -1 || fds[1] == -1 ||
+        (mh.msg_flags & (MSG_TRUNC | MSG_CTRUNC))) {
+        if (fds[0] != -1) close(fds[0]);
+        if (fds[1] != -1) close(fds[1]);
+        return -1;
+    }
+
+    memset(req, 0, sizeof(connection_request_t));
+    req->transport = msg[1];
+    memcpy(&req->client_id, msg + 2, sizeof(int));
+    req->req_fd = fds[0];
+    req->notif_fd = fds[1];
+    return 0;
+}
+
+void* socket_thread(void* arg) {
+    (void)arg;
+
+    // Bloquear SIGUSR1 (apenas thread anfitriã recebe)
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+    int listen_fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (listen_fd == -1) {
+        perror("Erro ao criar socket de ligações");
+        return NULL;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", listen_socket_path);
+    unlink(listen_socket_path);
+
+    if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) == -1 ||
+        listen(listen_fd, MAX_PENDING_CONNECTIONS) == -1) {
+        perror("Erro ao escutar no socket de ligações");
+        close(listen_fd);
+        return NULL;
+    }
+
+    fprintf(stderr, "SOCKET THREAD: a escutar em %s\n", listen_socket_path);
+
+    while (1) {
+        int conn_fd = accept(listen_fd, NULL, NULL);
+        if (conn_fd == -1) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            perror("Erro no accept do socket de ligações");
+            break;
+        }
+
+        // Um cliente que liga e não manda nada não pode prender a thread
+        struct timeval timeout = {1, 0};
+        setsockopt(conn_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        connection_request_t req;
+        int valid = read_socket_request(conn_fd, &req);
+        // A ligação só serve para entregar os canais
+        close(conn_fd);
+        if (valid < 0) continue;
+
+        // Canal multiplexado: as sessões são pedidas depois, lá dentro
+        if (req.transport == TRANSPORT_MUX) {
+            mux_open(&req);
+            continue;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &req.enqueued);
+        buffer_put(&connection_buffer, req);
+    }
+
+    close(listen_fd);
+    unlink(listen_socket_path);
+    return NULL;
+}
+
+// Inicia a sessão pedida dentro de um canal multiplexado (o pedido trazia
+// uma referência do canal, que passa para a sessão)
+static void mux_start_session(const connection_request_t* req, int session_idx) {
+    mux_conn_t* mux = req->mux;
+
+    // A entrada é ligada antes da resposta: nenhum comando que o cliente
+    // mande a seguir se perde
+    input_attach(session_idx, -1);
+
+    pthread_mutex_lock(&mux->lock);
+    int notif_fd = mux->closed ? -1 : dup(mux->notif_fd);
+    mux->slot_of[req->mux_id] = notif_fd != -1 ? session_idx : MUX_SLOT_FREE;
+    pthread_mutex_unlock(&mux->lock);
+
+    if (notif_fd == -1) {
+        input_detach(session_idx);
+        slot_release(session_idx);
+        mux_unref(mux);
+        return;
+    }
+
+    pthread_mutex_lock(&sessions_mutex);
+    sessions[session_idx].req_fd = -1;
+    sessions[session_idx].notif_fd = notif_fd;
+    pthread_mutex_unlock(&sessions_mutex);
+
+    if (mux_reply(notif_fd, req->mux_id, 0) < 0 ||
+        session_start(-1, notif_fd, session_idx, NULL, "", mux, req->mux_id) < 0) {
+        mux_session_finished(mux, req->mux_id, notif_fd, 1);
+        input_detach(session_idx);
+        close(notif_fd);
+        slot_release(session_idx);
+        mux_unref(mux);
+    }
+}
+
 void* worker_thread(void* arg) {
     (void)arg;
     
@@ -676,44 +1293,47 @@ void* worker_thread(void* arg) {
     while (1) {
         // Retirar pedido do buffer (bloqueia se vazio)
         connection_request_t req = buffer_get(&connection_buffer);
+        struct timespec dequeued, admitted;
+        clock_gettime(CLOCK_MONOTONIC, &dequeued);
 
-        // Esperar até existir um slot de sessão livre (bloqueia novos pedidos quando max_games está cheio)
-        int session_idx = -1;
-        while (1) {
-            pthread_mutex_lock(&sessions_mutex);
-            for (int i = 0; i < max_sessions; i++) {
-                if (!sessions[i].active) {
-                    session_idx = i;
-                    sessions[i].active = 1;      // reservar slot
-                    sessions[i].client_id = req.client_id;
-                    sessions[i].points = 0;
-                    break;
-                }
+        // Uma sessão multiplexada é recusada se max_games estiver cheio: o
+        // cliente está à espera da resposta e o canal pode tentar mais tarde
+        if (req.mux) {
+            int session_idx = slot_try_acquire(req.client_id);
+            if (session_idx == -1) {
+                mux_refuse_session(req.mux, req.mux_id);
+                continue;
             }
-            pthread_mutex_unlock(&sessions_mutex);
+            clock_gettime(CLOCK_MONOTONIC, &admitted);
+            admission_record(&req, &dequeued, &admitted);
+            mux_start_session(&req, session_idx);
+            continue;
+        }
 
-            if (session_idx != -1) {
-                break; // já temos sessão reservada para este cliente
-            }
+        // Esperar até existir um slot de sessão livre (acordado quando uma
+        // sessão termina; bloqueia novos pedidos quando max_games está cheio)
+        int session_idx = slot_acquire(req.client_id);
+        clock_gettime(CLOCK_MONOTONIC, &admitted);
+        admission_record(&req, &dequeued, &admitted);
 
-            // Nenhum slot livre ainda: aguardar um pouco antes de voltar a tentar
-            sleep_ms(50);
+        // Abrir pipes do cliente apenas depois de garantir uma sessão (as
+        // ligações por socket já trazem os canais abertos)
+        int req_fd = req.req_fd;
+        int notif_fd = req.notif_fd;
+        if (req_fd == -1) {
+            req_fd = open(req.req_pipe_path, O_RDONLY | O_NONBLOCK);
+            notif_fd = open(req.notif_pipe_path, O_WRONLY);
+        } else {
+            int flags = fcntl(req_fd, F_GETFL);
+            if (flags != -1) fcntl(req_fd, F_SETFL, flags | O_NONBLOCK);
         }
 
-        // Abrir pipes do cliente apenas depois de garantir uma sessão
-        int req_fd = open(req.req_pipe_path, O_RDONLY | O_NONBLOCK);
-        int notif_fd = open(req.notif_pipe_path, O_WRONLY);
-
         if (req_fd == -1 || notif_fd == -1) {
             if (req_fd != -1) close(req_fd);
             if (notif_fd != -1) close(notif_fd);
 
             // Libertar slot de sessão porque o cliente já não está disponível
-            pthread_mutex_lock(&sessions_mutex);
-            sessions[session_idx].active = 0;
-            sessions[session_idx].client_id = 0;
-            sessions[session_idx].points = 0;
-            pthread_mutex_unlock(&sessions_mutex);
+            slot_release(session_idx);
             continue;
         }
 
@@ -723,20 +1343,37 @@ void* worker_thread(void* arg) {
         sessions[session_idx].notif_fd = notif_fd;
         pthread_mutex_unlock(&sessions_mutex);
 
-        // Enviar confirmação (OP_CODE=1, result=0)
-        char response[2] = {OP_CODE_CONNECT, 0};
-        write(notif_fd, response, 2);
-        
-        // Criar thread do jogo para este cliente
-        // Arquitetura: worker cria thread de jogo para não ficar bloqueada
-        client_game_args_t* game_args = malloc(sizeof(client_game_args_t));
-        game_args->client_id = req.client_id;
-        game_args->req_fd = req_fd;
-        game_args->notif_fd = notif_fd;
-        game_args->levels_dir = strdup(levels_dir);
+        // Transporte dos tabuleiros: memória partilhada se o cliente a pediu
+        // e a região puder ser criada, senão o próprio FIFO
+        shm_producer_t* ring = NULL;
+        char shm_name[SHM_NAME_LENGTH] = {0};
+        if (req.transport == TRANSPORT_SHM) {
+            snprintf(shm_name, sizeof(shm_name), "/pacmanist_%d_%d_%u", (int)getpid(), session_idx,
+                     atomic_fetch_add(&shm_counter, 1));
+            ring = shm_ring_create(shm_name, level_cache_max_cells());
+        }
+
+        // Enviar confirmação (OP_CODE=1, result=0); OP_CODE_CONNECT_EX leva
+        // também o transporte escolhido
+        char response[3 + SHM_NAME_FIELD_LENGTH] = {OP_CODE_CONNECT, 0};
+        int response_len = 2;
+        if (req.transport >= 0) {
+            response[2] = ring ? TRANSPORT_SHM : TRANSPORT_PIPE;
+            memcpy(response + 3, shm_name, SHM_NAME_FIELD_LENGTH);
+            response_len = sizeof(response);
+        }
+        write(notif_fd, response, response_len);
         
-        pthread_create(&sessions[session_idx].game_thread, NULL,
-                      client_game_thread, game_args);
+        // A sessão passa a ser uma tarefa do motor (sem threads próprias)
+        if (session_start(req_fd, notif_fd, session_idx, ring, shm_name, NULL, 0) < 0) {
+            close(req_fd);
+            close(notif_fd);
+            if (ring) {
+                shm_ring_destroy(ring);
+                shm_unlink(shm_name);
+            }
+            slot_release(session_idx);
+        }
     }
     
     return NULL;
@@ -744,20 +1381,75 @@ void* worker_thread(void* arg) {
 
 // Main do servidor
 
+static void usage(const char* prog) {
+    fprintf(stderr, "Uso: %s [-e threads_motor] [-k keyframe] [-q fila] [-s ms] [-i política] [-I N] [-u socket] levels_dir max_games nome_do_FIFO_de_registo\n", prog);
+    fprintf(stderr, "  -e N  threads do motor de jogo (omissão/0 = número de cores)\n");
+    fprintf(stderr, "  -k N  frames delta entre tabuleiros completos (omissão %d, 0 = só completos)\n",
+            DEFAULT_KEYFRAME_INTERVAL);
+    fprintf(stderr, "  -q N  capacidade da fila de pedidos de conexão (omissão %d, arredondada a potência de 2)\n",
+            MAX_PENDING_CONNECTIONS);
+    fprintf(stderr, "  -s MS desligar clientes que não leem notificações há MS ms (omissão %d, 0 = nunca)\n",
+            DEFAULT_SLOW_CONSUMER_MS);
+    fprintf(stderr, "  -i P  política de entrada por tick: queue (omissão, pela ordem de chegada), latest ou drop-oldest\n");
+    fprintf(stderr, "  -I N  comandos guardados por sessão (omissão e mínimo %d: um lote inteiro)\n",
+            DEFAULT_INPUT_DEPTH);
+    fprintf(stderr, "  -u S  aceitar também ligações pelo socket Unix S (SOCK_SEQPACKET)\n");
+}
+
 int main(int argc, char** argv) {
-    if (argc != 4) {
-        fprintf(stderr, "Uso: %s levels_dir max_games nome_do_FIFO_de_registo\n", argv[0]);
+    int n_engine = 0;
+    int queue_size = MAX_PENDING_CONNECTIONS;
+    int input_policy = INPUT_QUEUE;
+    int input_depth = DEFAULT_INPUT_DEPTH;
+    int opt;
+    while ((opt = getopt(argc, argv, "e:k:q:s:i:I:u:")) != -1) {
+        switch (opt) {
+            case 'e':
+                n_engine = atoi(optarg);
+                break;
+            case 'k':
+                keyframe_interval = atoi(optarg);
+                break;
+            case 'q':
+                queue_size = atoi(optarg);
+                break;
+            case 's':
+                slow_consumer_ms = atoi(optarg);
+                break;
+            case 'i':
+                input_policy = input_policy_parse(optarg);
+                if (input_policy < 0) {
+                    fprintf(stderr, "Política de entrada desconhecida: %s\n", optarg);
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'I':
+                input_depth = atoi(optarg);
+                break;
+            case 'u':
+                listen_socket_path = optarg;
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (argc - optind != 3) {
+        usage(argv[0]);
         return 1;
     }
     
-    levels_dir = argv[1];
-    int max_games = atoi(argv[2]);
+    levels_dir = argv[optind];
+    int max_games = atoi(argv[optind + 1]);
+    char* register_arg = argv[optind + 2];
 
-    if (argv[3][0] == '/') {
-        snprintf(register_pipe_name, sizeof(register_pipe_name), "%s", argv[3]);
+    if (register_arg[0] == '/') {
+        snprintf(register_pipe_name, sizeof(register_pipe_name), "%s", register_arg);
     } else {
         uid_t uid = getuid();
-        snprintf(register_pipe_name, sizeof(register_pipe_name), "/tmp/%d_%s", (int)uid, argv[3]);
+        snprintf(register_pipe_name, sizeof(register_pipe_name), "/tmp/%d_%s", (int)uid, register_arg);
     }
     
     if (max_games <= 0) {
@@ -777,34 +1469,90 @@ int main(int argc, char** argv) {
     sigaddset(&set, SIGUSR1);
     pthread_sigmask(SIG_BLOCK, &set, NULL);
 
+    // Compilar todos os níveis uma única vez: as sessões apenas os copiam
+    int n_levels = level_cache_build(levels_dir);
+    if (n_levels <= 0) {
+        fprintf(stderr, "Nenhum nível encontrado em %s\n", levels_dir);
+        return 1;
+    }
+    fprintf(stderr, "%d níveis carregados para a cache\n", n_levels);
+
     // Inicializar buffer
-    buffer_init(&connection_buffer, MAX_PENDING_CONNECTIONS);
+    if (buffer_init(&connection_buffer, queue_size) < 0) {
+        fprintf(stderr, "Erro ao criar a fila de pedidos\n");
+        return 1;
+    }
     
     // Inicializar sessões
     max_sessions = max_games;
-    sessions = calloc(max_sessions, sizeof(client_session_t));
+    // Alinhado à linha de cache (sizeof(client_session_t) é múltiplo de 64)
+    sessions = aligned_alloc(_Alignof(client_session_t), max_sessions * sizeof(client_session_t));
+    if (sessions) {
+        for (int i = 0; i < max_sessions; i++) {
+            atomic_init(&sessions[i].points, 0);
+            atomic_init(&sessions[i].active, 0);
+            atomic_init(&sessions[i].client_id, 0);
+            sessions[i].req_fd = -1;
+            sessions[i].notif_fd = -1;
+        }
+    }
+    if (!sessions || slots_init(max_sessions) < 0 || leaderboard_init(max_sessions) < 0) {
+        fprintf(stderr, "Erro ao criar as sessões\n");
+        return 1;
+    }
+
+    // Os comandos dos clientes são lidos por uma thread própria (epoll)
+    if (input_init(max_sessions, input_policy, input_depth) < 0) {
+        fprintf(stderr, "Erro ao iniciar a leitura de comandos\n");
+        return 1;
+    }
     
+    // As sessões não têm threads próprias: o motor executa-as todas e basta
+    // um número fixo de workers para aceitar ligações
+    if (engine_init(n_engine) < 0) {
+        fprintf(stderr, "Erro ao iniciar o motor de jogo\n");
+        return 1;
+    }
+    fprintf(stderr, "Motor iniciado com %d threads\n", engine_threads());
+
+    int n_workers = max_games < MAX_WORKER_THREADS ? max_games : MAX_WORKER_THREADS;
+
+    // Relatórios (SIGUSR1) numa thread própria
+    sem_init(&report_sem, 0, 0);
+    pthread_t report_tid;
+    pthread_create(&report_tid, NULL, report_thread, NULL);
+
     // Criar thread anfitriã
     pthread_t host_tid;
     pthread_create(&host_tid, NULL, host_thread, NULL);
+
+    // Ligações por socket Unix, em paralelo com o FIFO de registo
+    if (listen_socket_path) {
+        pthread_t socket_tid;
+        pthread_create(&socket_tid, NULL, socket_thread, NULL);
+        pthread_detach(socket_tid);
+    }
     
-    // Criar threads worker (max_games threads)
-    pthread_t* worker_tids = malloc(max_games * sizeof(pthread_t));
-    for (int i = 0; i < max_games; i++) {
+    // Criar threads worker
+    pthread_t* worker_tids = malloc(n_workers * sizeof(pthread_t));
+    for (int i = 0; i < n_workers; i++) {
         pthread_create(&worker_tids[i], NULL, worker_thread, NULL);
     }
     
     // Aguardar (nunca retorna em condições normais)
     pthread_join(host_tid, NULL);
     
-    for (int i = 0; i < max_games; i++) {
+    for (int i = 0; i < n_workers; i++) {
         pthread_join(worker_tids[i], NULL);
     }
     
     // Limpeza (nunca alcançado)
     free(worker_tids);
     free(sessions);
+    free(free_slots);
+    leaderboard_destroy();
     buffer_destroy(&connection_buffer);
+    level_cache_destroy();
     
     return 0;
 }
@@ -0,0 +1,355 @@
+#include "session_input.h"
+#include "protocol.h"
+#include "debug.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/epoll.h>
+
+#define INPUT_MAX_EVENTS 64
+
+// ==================== ESTADO ====================
+
+typedef struct {
+    char command;
+    int repeat;                 // ticks que ainda faltam jogar
+    int started;                // já foi aplicado pelo menos uma vez
+    struct timespec arrived;    // CLOCK_MONOTONIC, quando a thread o leu
+} input_cmd_t;
+
+// Maior mensagem aceite (OP_CODE_PLAY_BATCH com MAX_PLAY_BATCH comandos)
+#define INPUT_MSG_MAX (PLAY_BATCH_HEADER_SIZE + MAX_PLAY_BATCH * PLAY_BATCH_ENTRY_SIZE)
+
+// Tem de caber um datagrama inteiro (canais SOCK_SEQPACKET cortam o resto)
+#define INPUT_READ_CHUNK (2 * INPUT_MSG_MAX)
+
+// Buffer de uma sessão (tudo protegido por lock, partilhado entre a thread
+// de leitura e o motor)
+typedef struct {
+    pthread_mutex_t lock;
+    int fd;                 // -1: slot sem sessão
+    int closed;
+    char msg[INPUT_MSG_MAX];    // mensagem ainda incompleta
+    int msg_len;
+    input_cmd_t* cmds;      // anel com capacity posições
+    int head;
+    int len;
+    // Estatísticas acumuladas (não são limpas entre sessões)
+    long applied;
+    long dropped;
+    long latency_us_total;
+    long latency_us_max;
+} input_slot_t;
+
+static input_slot_t* slots = NULL;
+static int n_input_slots = 0;
+static int input_policy = INPUT_QUEUE;
+static int capacity = 1;
+static int epoll_fd = -1;
+
+// ==================== POLÍTICAS ====================
+
+static const char* policy_names[] = {"latest", "queue", "drop-oldest"};
+
+int input_policy_parse(const char* name) {
+    for (int i = 0; i < (int)(sizeof(policy_names) / sizeof(policy_names[0])); i++) {
+        if (strcmp(name, policy_names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+const char* input_policy_name(int policy) {
+    if (policy < 0 || policy > INPUT_DROP_OLDEST) return "?";
+    return policy_names[policy];
+}
+
+// Guarda um comando acabado de chegar (chamar com s->lock)
+static void push_command(input_slot_t* s, char command, int repeat, const struct timespec* now) {
+    // 'G' não é um movimento: ignorar já, sem ocupar o buffer
+    if (command == 'G' || repeat <= 0) return;
+
+    if (s->len == capacity) {
+        if (input_policy == INPUT_QUEUE) {
+            s->dropped++;
+            return;
+        }
+        // drop-oldest: o mais antigo dá lugar ao novo
+        s->head = (s->head + 1) % capacity;
+        s->len--;
+        s->dropped++;
+    }
+
+    input_cmd_t* c = &s->cmds[(s->head + s->len) % capacity];
+    c->command = command;
+    c->repeat = repeat;
+    c->started = 0;
+    c->arrived = *now;
+    s->len++;
+}
+
+// Tamanho total da mensagem em s->msg, 0 se ainda não se sabe ou -1 se
+// não é válida
+static int message_size(const input_slot_t* s) {
+    switch (s->msg[0]) {
+        case OP_CODE_PLAY:
+            return 2;
+        case OP_CODE_PLAY_BATCH: {
+            if (s->msg_len < PLAY_BATCH_HEADER_SIZE) return 0;
+            int n;
+            memcpy(&n, s->msg + 1, sizeof(int));
+            if (n <= 0 || n > MAX_PLAY_BATCH) return -1;
+            return PLAY_BATCH_HEADER_SIZE + n * PLAY_BATCH_ENTRY_SIZE;
+        }
+        default:
+            return 1;
+    }
+}
+
+// Executa uma mensagem completa (chamar com s->lock)
+static void handle_message(input_slot_t* s) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    if (s->msg[0] == OP_CODE_DISCONNECT) {
+        s->closed = 1;
+        return;
+    }
+    if (s->msg[0] != OP_CODE_PLAY && s->msg[0] != OP_CODE_PLAY_BATCH) return;
+
+    // latest: a mensagem nova substitui tudo o que ainda estava por jogar
+    if (input_policy == INPUT_LATEST) {
+        s->dropped += s->len;
+        s->head = 0;
+        s->len = 0;
+    }
+
+    if (s->msg[0] == OP_CODE_PLAY) {
+        push_command(s, s->msg[1], 1, &now);
+        return;
+    }
+
+    int n;
+    memcpy(&n, s->msg + 1, sizeof(int));
+    const char* entry = s->msg + PLAY_BATCH_HEADER_SIZE;
+    for (int i = 0; i < n; i++, entry += PLAY_BATCH_ENTRY_SIZE) {
+        int repeat;
+        memcpy(&repeat, entry + 1, sizeof(int));
+        push_command(s, entry[0], repeat, &now);
+    }
+}
+
+// Interpreta os bytes lidos do FIFO (chamar com s->lock). Uma mensagem pode
+// ficar partida entre duas leituras.
+static void parse_input(input_slot_t* s, const char* data, ssize_t n) {
+    for (ssize_t i = 0; i < n && !s->closed; i++) {
+        s->msg[s->msg_len++] = data[i];
+
+        int size = message_size(s);
+        if (size < 0) {
+            fprintf(stderr, "Lote de comandos inválido: a desligar o cliente\n");
+            s->closed = 1;
+            break;
+        }
+        if (size == 0 || s->msg_len < size) continue;
+
+        handle_message(s);
+        s->msg_len = 0;
+    }
+}
+
+// ==================== THREAD DE LEITURA ====================
+
+static void stop_watching(input_slot_t* s) {
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, s->fd, NULL);
+    s->closed = 1;
+}
+
+// Lê um bloco do FIFO do slot. O registo no epoll é level-triggered: se
+// ficou mais por ler, o epoll_wait volta a dar o fd, depois das outras
+// sessões prontas (um cliente que mantém o FIFO cheio não prende a thread
+// nem o lock do slot)
+static void drain_slot(int slot) {
+    input_slot_t* s = &slots[slot];
+    char data[INPUT_READ_CHUNK];
+
+    pthread_mutex_lock(&s->lock);
+    // Evento de uma sessão que entretanto já saiu
+    if (s->fd != -1 && !s->closed) {
+        ssize_t n = read(s->fd, data, sizeof(data));
+        if (n > 0) {
+            parse_input(s, data, n);
+        } else if (n == 0 || (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK)) {
+            // EOF (o cliente fechou o FIFO) ou erro
+            stop_watching(s);
+        }
+    }
+    pthread_mutex_unlock(&s->lock);
+}
+
+static void* input_thread(void* arg) {
+    (void)arg;
+
+    // Bloquear SIGUSR1 (apenas thread anfitriã recebe)
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+    struct epoll_event events[INPUT_MAX_EVENTS];
+    while (1) {
+        int n = epoll_wait(epoll_fd, events, INPUT_MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("Erro no epoll_wait da entrada");
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            drain_slot((int)events[i].data.u32);
+        }
+    }
+    return NULL;
+}
+
+// ==================== API ====================
+
+int input_init(int n_slots, int policy, int depth) {
+    input_policy = policy;
+    capacity = depth > MAX_PLAY_BATCH ? depth : MAX_PLAY_BATCH;
+
+    slots = calloc(n_slots, sizeof(input_slot_t));
+    if (!slots) return -1;
+    n_input_slots = n_slots;
+
+    for (int i = 0; i < n_slots; i++) {
+        pthread_mutex_init(&slots[i].lock, NULL);
+        slots[i].fd = -1;
+        slots[i].cmds = malloc(capacity * sizeof(input_cmd_t));
+        if (!slots[i].cmds) return -1;
+    }
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd == -1) {
+        perror("Erro ao criar epoll da entrada");
+        return -1;
+    }
+
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, input_thread, NULL) != 0) return -1;
+    pthread_detach(tid);
+    return 0;
+}
+
+int input_attach(int slot, int fd) {
+    if (slot < 0 || slot >= n_input_slots) return -1;
+    input_slot_t* s = &slots[slot];
+
+    pthread_mutex_lock(&s->lock);
+    s->fd = fd;
+    s->closed = 0;
+    s->msg_len = 0;
+    s->head = 0;
+    s->len = 0;
+
+    // Sessão de um canal multiplexado: os comandos chegam por input_feed
+    if (fd == -1) {
+        pthread_mutex_unlock(&s->lock);
+        return 0;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u32 = (uint32_t)slot;
+    int rc = epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+    if (rc == -1) {
+        perror("Erro ao registar FIFO de pedidos no epoll");
+        s->fd = -1;
+    }
+    pthread_mutex_unlock(&s->lock);
+    return rc;
+}
+
+void input_detach(int slot) {
+    if (slot < 0 || slot >= n_input_slots) return;
+    input_slot_t* s = &slots[slot];
+
+    pthread_mutex_lock(&s->lock);
+    if (s->fd != -1 && !s->closed) {
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, s->fd, NULL);
+    }
+    s->fd = -1;
+    s->len = 0;
+    pthread_mutex_unlock(&s->lock);
+}
+
+void input_feed(int slot, const char* msg, int len) {
+    if (slot < 0 || slot >= n_input_slots || len <= 0) return;
+    input_slot_t* s = &slots[slot];
+
+    pthread_mutex_lock(&s->lock);
+    // Cada mensagem chega inteira: descartar restos de uma anterior inválida
+    s->msg_len = 0;
+    if (!s->closed) parse_input(s, msg, len);
+    pthread_mutex_unlock(&s->lock);
+}
+
+int input_next(int slot, char* command) {
+    if (slot < 0 || slot >= n_input_slots) return INPUT_CLOSED;
+    input_slot_t* s = &slots[slot];
+    int result = INPUT_NONE;
+
+    pthread_mutex_lock(&s->lock);
+    if (s->closed) {
+        result = INPUT_CLOSED;
+    } else if (s->len > 0) {
+        input_cmd_t* c = &s->cmds[s->head];
+
+        // A latência conta até à primeira vez que o comando é jogado
+        if (!c->started) {
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            long latency_us = timespec_diff_us(&now, &c->arrived);
+            s->applied++;
+            s->latency_us_total += latency_us;
+            if (latency_us > s->latency_us_max) s->latency_us_max = latency_us;
+            c->started = 1;
+        }
+
+        *command = c->command;
+        if (--c->repeat == 0) {
+            s->head = (s->head + 1) % capacity;
+            s->len--;
+        }
+        result = INPUT_COMMAND;
+    }
+    pthread_mutex_unlock(&s->lock);
+    return result;
+}
+
+void input_report_stats(void) {
+    long applied = 0, dropped = 0, total_us = 0, max_us = 0;
+    for (int i = 0; i < n_input_slots; i++) {
+        input_slot_t* s = &slots[i];
+        pthread_mutex_lock(&s->lock);
+        applied += s->applied;
+        dropped += s->dropped;
+        total_us += s->latency_us_total;
+        if (s->latency_us_max > max_us) max_us = s->latency_us_max;
+        pthread_mutex_unlock(&s->lock);
+    }
+
+    if (applied == 0) {
+        fprintf(stderr, "ENTRADA (%s, %d): nenhum comando aplicado, %ld descartados.\n",
+                input_policy_name(input_policy), capacity, dropped);
+        return;
+    }
+    fprintf(stderr,
+        "ENTRADA (%s, %d): %ld comandos aplicados | chegada -> aplicação: média %.3f ms, máx %.3f ms | %ld descartados\n",
+        input_policy_name(input_policy), capacity, applied,
+        total_us / 1000.0 / applied, max_us / 1000.0, dropped);
+}
@@ -0,0 +1,176 @@
+#define _GNU_SOURCE // syscall()
+#include "shm_ring.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+// ==================== FUTEX ====================
+// Sem FUTEX_PRIVATE_FLAG: a palavra está numa região partilhada entre processos
+
+static void futex_wait(_Atomic uint32_t* addr, uint32_t expected, int timeout_ms) {
+    struct timespec ts = {timeout_ms / 1000, (timeout_ms % 1000) * 1000000L};
+    syscall(SYS_futex, (uint32_t*)addr, FUTEX_WAIT, expected, &ts, NULL, 0);
+}
+
+static void futex_wake(_Atomic uint32_t* addr) {
+    syscall(SYS_futex, (uint32_t*)addr, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+// ==================== REGIÃO ====================
+
+static size_t ring_size(uint32_t slot_stride) {
+    return sizeof(shm_ring_t) + (size_t)SHM_RING_SLOTS * slot_stride;
+}
+
+static shm_frame_t* ring_slot(shm_ring_t* ring, uint32_t slot_stride, uint32_t index) {
+    return (shm_frame_t*)(ring->slots + (size_t)(index & (SHM_RING_SLOTS - 1)) * slot_stride);
+}
+
+shm_producer_t* shm_ring_create(const char* name, int max_cells) {
+    // Cada frame começa numa linha de cache própria
+    uint32_t stride = (sizeof(shm_frame_t) + max_cells + 1 + 63) & ~63u;
+    size_t bytes = ring_size(stride);
+
+    shm_producer_t* producer = malloc(sizeof(shm_producer_t));
+    if (!producer) return NULL;
+
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd == -1) {
+        perror("Erro ao criar memória partilhada");
+        free(producer);
+        return NULL;
+    }
+    if (ftruncate(fd, bytes) == -1) {
+        perror("Erro ao dimensionar memória partilhada");
+        close(fd);
+        shm_unlink(name);
+        free(producer);
+        return NULL;
+    }
+
+    shm_ring_t* ring = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ring == MAP_FAILED) {
+        perror("Erro ao mapear memória partilhada");
+        shm_unlink(name);
+        free(producer);
+        return NULL;
+    }
+
+    // A região vem a zeros do ftruncate; estes campos são só para o cliente
+    ring->n_slots = SHM_RING_SLOTS;
+    ring->slot_stride = stride;
+    ring->max_cells = max_cells;
+    atomic_store(&ring->head, 0);
+    atomic_store(&ring->tail, 0);
+    atomic_store_explicit(&ring->closed, 0, memory_order_relaxed);
+    // Publicar o magic por último: o cliente só confia na região depois dele
+    __atomic_store_n(&ring->magic, SHM_RING_MAGIC, __ATOMIC_RELEASE);
+
+    producer->shared = ring;
+    producer->size = bytes;
+    producer->slot_stride = stride;
+    producer->head = 0;
+    return producer;
+}
+
+shm_frame_t* shm_ring_reserve(shm_producer_t* producer) {
+    uint32_t tail = atomic_load_explicit(&producer->shared->tail, memory_order_acquire);
+    // tail é escrito pelo cliente: se diz ter libertado mais frames do que
+    // as publicadas, head - tail dá a volta e o anel conta como cheio
+    if (producer->head - tail >= SHM_RING_SLOTS) return NULL;
+    return ring_slot(producer->shared, producer->slot_stride, producer->head);
+}
+
+void shm_ring_publish(shm_producer_t* producer) {
+    // Ordem sequencial com consumer_waiting: ou o cliente vê o novo head antes
+    // de dormir, ou nós vemos que está à espera e acordamo-lo
+    atomic_store(&producer->shared->head, ++producer->head);
+    if (atomic_load(&producer->shared->consumer_waiting)) {
+        futex_wake(&producer->shared->head);
+    }
+}
+
+void shm_ring_close(shm_producer_t* producer) {
+    atomic_store(&producer->shared->closed, 1);
+    futex_wake(&producer->shared->head);
+}
+
+void shm_ring_destroy(shm_producer_t* producer) {
+    if (!producer) return;
+    munmap(producer->shared, producer->size);
+    free(producer);
+}
+
+// ==================== CLIENTE ====================
+
+shm_ring_t* shm_ring_attach(const char* name, size_t* size) {
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd == -1) return NULL;
+
+    // Ninguém mais precisa do nome: sai de /dev/shm mesmo que o cliente morra
+    shm_unlink(name);
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(shm_ring_t)) {
+        close(fd);
+        return NULL;
+    }
+
+    shm_ring_t* ring = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ring == MAP_FAILED) return NULL;
+
+    if (__atomic_load_n(&ring->magic, __ATOMIC_ACQUIRE) != SHM_RING_MAGIC ||
+        ring->n_slots != SHM_RING_SLOTS || ring_size(ring->slot_stride) > (size_t)st.st_size) {
+        munmap(ring, st.st_size);
+        return NULL;
+    }
+
+    *size = st.st_size;
+    return ring;
+}
+
+shm_frame_t* shm_ring_next(shm_ring_t* ring, int timeout_ms, int* closed) {
+    *closed = 0;
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    if (head == ring->next_read && timeout_ms > 0) {
+        atomic_store(&ring->consumer_waiting, 1);
+        head = atomic_load(&ring->head);
+        if (head == ring->next_read && !atomic_load(&ring->closed)) {
+            futex_wait(&ring->head, head, timeout_ms);
+        }
+        atomic_store(&ring->consumer_waiting, 0);
+        head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    }
+
+    if (head == ring->next_read) {
+        // closed é escrito depois da última frame: voltar a olhar para head
+        if (atomic_load_explicit(&ring->closed, memory_order_acquire) &&
+            atomic_load_explicit(&ring->head, memory_order_acquire) == ring->next_read) {
+            *closed = 1;
+        }
+        return NULL;
+    }
+
+    return ring_slot(ring, ring->slot_stride, ring->next_read++);
+}
+
+void shm_ring_wake(shm_ring_t* ring) {
+    futex_wake(&ring->head);
+}
+
+void shm_ring_release(shm_ring_t* ring) {
+    atomic_fetch_add_explicit(&ring->tail, 1, memory_order_release);
+}
+
+void shm_ring_unmap(shm_ring_t* ring, size_t size) {
+    if (ring) munmap(ring, size);
+}